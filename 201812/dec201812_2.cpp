@@ -9,14 +9,24 @@
 // Printing out the sum for the first few hundred generations shows that the
 // value fluctuates initially, but after generation 94 the difference between
 // consecutive sums is always 22.
+//
+// Rather than relying on the difference staying the same, which fails for
+// rules that oscillate, we record the pattern of pots after each generation,
+// shifted so the first plant is at position zero, along with the position
+// of that first plant. Once a pattern repeats, the state at any later
+// generation is the state from within the cycle shifted by a whole number
+// of periods, so we can compute the sum directly.
 
 #include <array>
+#include <cstdint>
 #include <deque>
 #include <iostream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
-constexpr int num_rounds = 200;
+constexpr std::int64_t target_generation = 50000000000LL;
+constexpr int max_rounds = 10000;
 
 std::deque<int> read_initial_state()
 {
@@ -59,6 +69,27 @@ std::array<int, 32> read_rules_lookup()
 	return rule_lookup;
 }
 
+// Pots from first to last plant, and the number of the first pot
+std::pair<std::string, std::int64_t> normalized_pattern(const std::deque<int> &state, int round)
+{
+	std::string pattern;
+	std::int64_t first = -1;
+
+	for (int i = 0; i < state.size(); ++i) {
+		if (state[i] != 0) {
+			if (first == -1) {
+				first = i;
+			}
+			pattern.resize(i - first, '.');
+			pattern.push_back('#');
+		}
+	}
+
+	// Subtracting twice round since we added two pots to the front every
+	// round
+	return { pattern, first - 2 * static_cast<std::int64_t>(round) };
+}
+
 int main()
 {
 	auto state = read_initial_state();
@@ -67,54 +98,88 @@ int main()
 
 	std::deque<int> next;
 
-	int round = 0;
-	int prev_sum = 0;
-	int prev_difference = 0;
-	int num_repeats = 0;
+	// Generation each pattern was first seen, and the sum of pot numbers,
+	// number of plants and offset of the pattern at each generation
+	std::unordered_map<std::string, int> seen;
+	std::vector<std::int64_t> sums;
+	std::vector<std::int64_t> counts;
+	std::vector<std::int64_t> offsets;
 
-	for (; round < num_rounds; ++round) {
-		// Add empty pots to front and back of state so loop
-		// below will apply the rules expanding by one pot in
-		// each direction
-		state.push_front(0);
-		state.push_back(0);
-		state.push_back(0);
-		state.push_back(0);
+	int cycle_start = -1;
+	int period = 0;
+	std::int64_t shift = 0;
 
-		unsigned int mask = state[1];
+	for (int round = 0; round <= max_rounds; ++round) {
+		auto [pattern, offset] = normalized_pattern(state, round);
 
-		for (int i = 0; i < state.size() - 2; ++i) {
-			mask = (mask << 1) | static_cast<unsigned int>(state[i + 2]);
-			next.push_back(lookup[mask & 0x1FU]);
+		std::int64_t sum = 0;
+		std::int64_t count = 0;
+
+		for (std::int64_t i = 0; i < pattern.size(); ++i) {
+			if (pattern[i] == '#') {
+				sum += offset + i;
+				++count;
+			}
 		}
 
-		state.swap(next);
-		next.clear();
+		if (auto it = seen.find(pattern); it != seen.end()) {
+			cycle_start = it->second;
+			period = round - cycle_start;
+			shift = offset - offsets[cycle_start];
+			break;
+		}
 
-		int sum = 0;
+		seen.emplace(std::move(pattern), round);
+		sums.push_back(sum);
+		counts.push_back(count);
+		offsets.push_back(offset);
 
-		for (int i = 0; i < state.size(); ++i) {
-			if (state[i] != 0) {
-				sum += i - (round + 1);
-			}
+		if (round == target_generation) {
+			break;
 		}
 
-		if (sum - prev_sum == prev_difference) {
-			std::cout << prev_difference << " repeated @ round " << round << '\n';
+		// Add two empty pots to front and back of state so loop
+		// below will apply the rules expanding by two pots in
+		// each direction, which rules like ....# => # need
+		state.push_front(0);
+		state.push_front(0);
+		state.push_back(0);
+		state.push_back(0);
+
+		unsigned int mask = 0;
+
+		for (int i = 0; i < state.size() + 2; ++i) {
+			unsigned int pot = i < state.size() ? static_cast<unsigned int>(state[i]) : 0U;
+			mask = (mask << 1) | pot;
 
-			if (++num_repeats == 5) {
-				break;
+			if (i >= 2) {
+				next.push_back(lookup[mask & 0x1FU]);
 			}
 		}
-		else {
-			num_repeats = 0;
-		}
 
-		prev_difference = sum - prev_sum;
-		prev_sum = sum;
+		state.swap(next);
+		next.clear();
+	}
+
+	if (target_generation < sums.size()) {
+		std::cout << sums[target_generation] << '\n';
+		return 0;
 	}
 
-	std::cout << (50000000000LL - round) * prev_difference + prev_sum << '\n';
+	if (cycle_start == -1) {
+		std::cerr << "no repeating pattern within " << max_rounds << " generations\n";
+		exit(1);
+	}
+
+	std::cout << "generation " << cycle_start + period << " repeats generation " << cycle_start
+	          << " shifted by " << shift << '\n';
+
+	// The state at the target generation is the state at generation gen
+	// within the cycle, shifted num_periods times
+	std::int64_t num_periods = (target_generation - cycle_start) / period;
+	std::int64_t gen = cycle_start + (target_generation - cycle_start) % period;
+
+	std::cout << sums[gen] + num_periods * shift * counts[gen] << '\n';
 
 	return 0;
 }
@@ -0,0 +1,153 @@
+//
+// Advent of Code 2018, day 12, sparse simulation
+//
+
+// Simulates the number of generations given on the command line (default
+// 20, which gives the answer to part one) and prints the sum of the pot
+// numbers containing plants.
+//
+// The state is kept as sorted runs of consecutive plants, and the rules are
+// only applied within two pots of a run, so time and memory depend on the
+// number of plants rather than the distance between the first and last.
+//
+// Besides the usual "initial state: #..#" line, the input may contain lines
+// of the form "initial state @ -1000000000000: #.##" which place plants
+// starting at the given pot number.
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Runs of plants [first, second), sorted and not touching
+using Runs = std::vector<std::pair<std::int64_t, std::int64_t>>;
+
+void add_pot(Runs &runs, std::int64_t pot)
+{
+	if (!runs.empty() && runs.back().second == pot) {
+		runs.back().second = pot + 1;
+	}
+	else {
+		runs.emplace_back(pot, pot + 1);
+	}
+}
+
+std::pair<Runs, std::array<int, 32>> read_input()
+{
+	std::vector<std::int64_t> pots;
+	std::array<int, 32> rule_lookup = {};
+
+	std::string line;
+
+	while (std::getline(std::cin, line)) {
+		if (auto p = line.find("=>"); p != std::string::npos) {
+			unsigned int mask = 0;
+
+			for (char ch : line.substr(0, 5)) {
+				mask = (mask << 1) | ((ch == '#') ? 1U : 0U);
+			}
+
+			rule_lookup[mask] = line[p + 3] == '#' ? 1 : 0;
+		}
+		else if (auto p = line.find(':'); p != std::string::npos) {
+			std::int64_t start = 0;
+
+			if (auto at = line.find('@'); at != std::string::npos && at < p) {
+				start = std::strtoll(line.c_str() + at + 1, nullptr, 10);
+			}
+
+			for (std::size_t i = p + 2; i < line.size(); ++i) {
+				if (line[i] == '#') {
+					pots.push_back(start + static_cast<std::int64_t>(i - (p + 2)));
+				}
+			}
+		}
+	}
+
+	std::sort(pots.begin(), pots.end());
+
+	Runs runs;
+
+	for (std::size_t i = 0; i < pots.size(); ++i) {
+		if (i == 0 || pots[i] != pots[i - 1]) {
+			add_pot(runs, pots[i]);
+		}
+	}
+
+	return { runs, rule_lookup };
+}
+
+Runs step(const Runs &runs, const std::array<int, 32> &lookup)
+{
+	Runs next;
+
+	std::size_t cursor = 0;
+
+	auto is_plant = [&](std::int64_t pot) {
+		while (cursor < runs.size() && runs[cursor].second <= pot) {
+			++cursor;
+		}
+
+		return cursor < runs.size() && runs[cursor].first <= pot;
+	};
+
+	std::size_t i = 0;
+
+	while (i < runs.size()) {
+		// Pots that can change are within two of a run, merge runs
+		// whose windows touch so each pot is visited once
+		std::int64_t begin = runs[i].first - 2;
+		std::int64_t end = runs[i].second + 2;
+
+		for (++i; i < runs.size() && runs[i].first - 2 <= end + 4; ++i) {
+			end = runs[i].second + 2;
+		}
+
+		unsigned int mask = 0;
+
+		for (std::int64_t pot = begin - 2; pot < end + 2; ++pot) {
+			mask = (mask << 1) | (is_plant(pot) ? 1U : 0U);
+
+			if (pot >= begin + 2 && lookup[mask & 0x1FU] != 0) {
+				add_pot(next, pot - 2);
+			}
+		}
+	}
+
+	return next;
+}
+
+std::int64_t pot_sum(const Runs &runs)
+{
+	std::int64_t sum = 0;
+
+	for (auto [first, last] : runs) {
+		sum += (first + last - 1) * (last - first) / 2;
+	}
+
+	return sum;
+}
+
+int main(int argc, char *argv[])
+{
+	long long num_rounds = argc > 1 ? std::atoll(argv[1]) : 20;
+
+	auto [runs, lookup] = read_input();
+
+	if (lookup[0] != 0) {
+		std::cerr << "rule ..... => # fills infinitely many pots\n";
+		exit(1);
+	}
+
+	for (long long round = 0; round < num_rounds; ++round) {
+		runs = step(runs, lookup);
+	}
+
+	std::cout << pot_sum(runs) << '\n';
+
+	return 0;
+}
@@ -0,0 +1,196 @@
+//
+// Advent of Code 2018, day 13, part two
+//
+
+// The first solution draws the carts onto the map, sorts all carts every
+// tick, and on a crash searches all carts for the one that was hit.
+//
+// Here the track is kept free of carts, and a separate grid holds the
+// index of the cart in each cell (or -1), so finding the cart that was hit
+// is a single lookup. Cart data is kept in separate arrays, and the order
+// the carts move in is maintained with an insertion sort, since each cart
+// moves at most one cell per tick and the order is nearly sorted already.
+//
+// This makes large maps with on the order of 10^5 carts practical.
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct Carts {
+	// Position as index into the map, direction (0 = up, clockwise),
+	// and which way to go at the next intersection
+	std::vector<int> pos;
+	std::vector<int> dir;
+	std::vector<int> next_dir;
+	std::vector<bool> alive;
+
+	// Indices of carts that are still alive, in the order they move
+	std::vector<int> order;
+};
+
+std::vector<std::string> read_map()
+{
+	std::vector<std::string> map;
+	std::string line;
+
+	while (std::getline(std::cin, line)) {
+		map.push_back(line);
+	}
+
+	return map;
+}
+
+int cart_dir(char ch)
+{
+	switch (ch) {
+	case '^':
+		return 0;
+	case '>':
+		return 1;
+	case 'v':
+		return 2;
+	case '<':
+		return 3;
+	default:
+		return -1;
+	}
+}
+
+// Copy map into a track grid of width * height cells with carts removed,
+// and store the carts in carts
+std::vector<char> extract_carts(const std::vector<std::string> &map, int width, Carts &carts)
+{
+	std::vector<char> track(map.size() * width, ' ');
+
+	for (int y = 0; y < map.size(); ++y) {
+		for (int x = 0; x < map[y].size(); ++x) {
+			char ch = map[y][x];
+
+			if (int dir = cart_dir(ch); dir != -1) {
+				carts.pos.push_back(y * width + x);
+				carts.dir.push_back(dir);
+				carts.next_dir.push_back(0);
+				carts.alive.push_back(true);
+				carts.order.push_back(static_cast<int>(carts.order.size()));
+
+				ch = dir % 2 == 0 ? '|' : '-';
+			}
+
+			track[y * width + x] = ch;
+		}
+	}
+
+	return track;
+}
+
+// Sort order by position, which is the same as sorting by y, then x
+void sort_order(Carts &carts)
+{
+	auto &order = carts.order;
+
+	for (int i = 1; i < order.size(); ++i) {
+		int id = order[i];
+		int pos = carts.pos[id];
+		int j = i;
+
+		for (; j > 0 && carts.pos[order[j - 1]] > pos; --j) {
+			order[j] = order[j - 1];
+		}
+
+		order[j] = id;
+	}
+}
+
+void tick(const std::vector<char> &track, std::vector<int> &occupied, int width, Carts &carts)
+{
+	const int offset[4] = { -width, 1, width, -1 };
+
+	for (int id : carts.order) {
+		if (!carts.alive[id]) {
+			continue;
+		}
+
+		occupied[carts.pos[id]] = -1;
+
+		int pos = carts.pos[id] + offset[carts.dir[id]];
+
+		carts.pos[id] = pos;
+
+		if (int other = occupied[pos]; other != -1) {
+			carts.alive[id] = false;
+			carts.alive[other] = false;
+			occupied[pos] = -1;
+			continue;
+		}
+
+		occupied[pos] = id;
+
+		int &dir = carts.dir[id];
+
+		switch (track[pos]) {
+		case '/':
+			dir ^= 1;
+			break;
+		case '\\':
+			dir = 3 - dir;
+			break;
+		case '+':
+			dir = (dir + 3 + carts.next_dir[id]) % 4;
+			carts.next_dir[id] = (carts.next_dir[id] + 1) % 3;
+			break;
+		default:
+			break;
+		}
+	}
+
+	// Remove crashed carts and restore order
+	auto &order = carts.order;
+	std::size_t num_alive = 0;
+
+	for (int id : order) {
+		if (carts.alive[id]) {
+			order[num_alive++] = id;
+		}
+	}
+
+	order.resize(num_alive);
+
+	sort_order(carts);
+}
+
+int main()
+{
+	auto map = read_map();
+
+	int width = 0;
+
+	for (const auto &line : map) {
+		width = std::max(width, static_cast<int>(line.size()));
+	}
+
+	Carts carts;
+
+	auto track = extract_carts(map, width, carts);
+
+	std::vector<int> occupied(track.size(), -1);
+
+	for (int id : carts.order) {
+		occupied[carts.pos[id]] = id;
+	}
+
+	std::cout << carts.order.size() << " carts\n";
+
+	for (int t = 0; t < 100000; ++t) {
+		tick(track, occupied, width, carts);
+
+		if (carts.order.size() == 1) {
+			int pos = carts.pos[carts.order[0]];
+			std::cout << "last cart at " << pos % width << ',' << pos / width << '\n';
+			exit(0);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,513 @@
+//
+// Advent of Code 2018, day 13, both parts
+//
+
+// Most ticks just move carts along straight track, so instead of moving
+// every cart every tick, each cart is described by a leg: the time and
+// cell it started at, its direction, and when it reaches the next curve or
+// intersection (a node). Between nodes the position of a cart is a linear
+// function of time.
+//
+// An event queue holds the times carts reach nodes, where a new leg
+// starts, and the times of possible crashes. When a leg starts, it is
+// checked against the current legs of the carts that share cells with it,
+// which are the carts on the same stretch of track (segment), and the
+// carts whose legs start or end at one of its nodes.
+//
+// Within a tick carts move in the same order as operator< in the other
+// solutions, by y and then x of their position at the start of the tick.
+// Two carts a and b crash at tick t if a moves first and moves into the
+// cell b has not left yet, or b moves second into the cell a just moved
+// to, or the same with a and b swapped. With linear positions each of these
+// gives a linear equation in t, so the first crash of a pair of legs is
+// found directly.
+
+#include <algorithm>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+constexpr int max_ticks = 100000;
+
+constexpr int dx[4] = { 0, 1, 0, -1 };
+constexpr int dy[4] = { -1, 0, 1, 0 };
+
+struct Leg {
+	int t0 = 0;
+	int x0 = 0;
+	int y0 = 0;
+	int dir = 0;
+	int t_end = 0;
+	int start_node = -1;
+	int end_node = -1;
+	long long segment = 0;
+};
+
+struct Cart {
+	Leg leg;
+	int leg_id = 0;
+	int next_dir = 0;
+	bool alive = true;
+};
+
+// Events are ordered by tick, then crashes before carts reaching nodes,
+// then by the position of the moving cart at the start of the tick
+struct Event {
+	int t = 0;
+	int kind = 0;
+	int key = 0;
+	int cart = 0;
+	int leg_id = 0;
+
+	bool operator>(const Event &rhs) const
+	{
+		return std::tie(t, kind, key) > std::tie(rhs.t, rhs.kind, rhs.key);
+	}
+};
+
+constexpr int kind_crash = 0;
+constexpr int kind_node = 1;
+
+std::vector<std::string> read_map()
+{
+	std::vector<std::string> map;
+	std::string line;
+
+	while (std::getline(std::cin, line)) {
+		map.push_back(line);
+	}
+
+	return map;
+}
+
+int cart_dir(char ch)
+{
+	switch (ch) {
+	case '^':
+		return 0;
+	case '>':
+		return 1;
+	case 'v':
+		return 2;
+	case '<':
+		return 3;
+	default:
+		return -1;
+	}
+}
+
+bool is_node(char ch)
+{
+	return ch == '/' || ch == '\\' || ch == '+';
+}
+
+// Set of ticks solving c * t == r, which is either none, all, or one
+struct Solution {
+	bool any = false;
+	bool all = false;
+	int t = 0;
+};
+
+Solution solve_linear(long long c, long long r)
+{
+	if (c == 0) {
+		return { r == 0, r == 0, 0 };
+	}
+	if (r % c != 0) {
+		return {};
+	}
+	return { true, false, static_cast<int>(r / c) };
+}
+
+Solution intersect(const Solution &lhs, const Solution &rhs)
+{
+	if (!lhs.any || !rhs.any) {
+		return {};
+	}
+	if (lhs.all) {
+		return rhs;
+	}
+	if (rhs.all || lhs.t == rhs.t) {
+		return lhs;
+	}
+	return {};
+}
+
+class Simulation {
+public:
+	explicit Simulation(const std::vector<std::string> &map)
+	{
+		height = static_cast<int>(map.size());
+
+		for (const auto &line : map) {
+			width = std::max(width, static_cast<int>(line.size()));
+		}
+
+		track.assign(width * height, ' ');
+
+		for (int y = 0; y < height; ++y) {
+			for (int x = 0; x < map[y].size(); ++x) {
+				char ch = map[y][x];
+
+				if (int dir = cart_dir(ch); dir != -1) {
+					Cart cart;
+					cart.leg.x0 = x;
+					cart.leg.y0 = y;
+					cart.leg.dir = dir;
+					carts.push_back(cart);
+
+					ch = dir % 2 == 0 ? '|' : '-';
+				}
+
+				track[y * width + x] = ch;
+			}
+		}
+
+		edge_len.assign(4 * track.size(), -1);
+		node_legs.resize(track.size());
+
+		num_alive = static_cast<int>(carts.size());
+
+		for (int id = 0; id < carts.size(); ++id) {
+			start_leg(id, 0, carts[id].leg.x0, carts[id].leg.y0, carts[id].leg.dir);
+		}
+	}
+
+	int num_carts() const { return static_cast<int>(carts.size()); }
+
+	// Run until one cart is left, printing the first crash and the last
+	// cart
+	void run()
+	{
+		while (!events.empty()) {
+			Event ev = events.top();
+			events.pop();
+
+			// Stop at the end of the tick where one cart is left
+			if ((num_alive <= 1 && ev.t > last_crash_tick) || ev.t > max_ticks) {
+				break;
+			}
+
+			if (ev.kind == kind_node) {
+				reach_node(ev);
+			}
+			else {
+				crash(ev);
+			}
+		}
+
+		for (const auto &cart : carts) {
+			if (cart.alive && num_alive == 1) {
+				auto [x, y] = position(cart.leg, last_crash_tick);
+				std::cout << "last cart at " << x << ',' << y << '\n';
+			}
+		}
+	}
+
+private:
+	int width = 0;
+	int height = 0;
+	std::vector<char> track;
+	std::vector<Cart> carts;
+	int num_alive = 0;
+	int last_crash_tick = 1;
+
+	// Length of the straight run from each node in each direction
+	std::vector<int> edge_len;
+
+	// Carts with legs on each segment, and with legs starting or ending
+	// at each node, as cart and leg id, possibly stale
+	std::unordered_map<long long, std::vector<std::pair<int, int>>> segment_legs;
+	std::vector<std::vector<std::pair<int, int>>> node_legs;
+
+	std::priority_queue<Event, std::vector<Event>, std::greater<>> events;
+
+	std::pair<int, int> position(const Leg &leg, int t) const
+	{
+		return { leg.x0 + dx[leg.dir] * (t - leg.t0), leg.y0 + dy[leg.dir] * (t - leg.t0) };
+	}
+
+	int key(const Leg &leg, int t) const
+	{
+		auto [x, y] = position(leg, t);
+		return y * width + x;
+	}
+
+	// Number of steps from cell in direction dir to the next node
+	int steps_to_node(int cell, int dir)
+	{
+		bool memo = is_node(track[cell]);
+
+		if (memo && edge_len[4 * cell + dir] != -1) {
+			return edge_len[4 * cell + dir];
+		}
+
+		int offset = dy[dir] * width + dx[dir];
+		int steps = 0;
+		int pos = cell;
+
+		do {
+			pos += offset;
+			++steps;
+		} while (!is_node(track[pos]));
+
+		if (memo) {
+			edge_len[4 * cell + dir] = steps;
+		}
+
+		return steps;
+	}
+
+	void start_leg(int id, int t, int x, int y, int dir)
+	{
+		Cart &cart = carts[id];
+		Leg &leg = cart.leg;
+
+		int cell = y * width + x;
+		int offset = dy[dir] * width + dx[dir];
+		int steps = steps_to_node(cell, dir);
+
+		leg.t0 = t;
+		leg.x0 = x;
+		leg.y0 = y;
+		leg.dir = dir;
+		leg.t_end = t + steps;
+		leg.end_node = cell + steps * offset;
+
+		int back_node = cell;
+
+		if (is_node(track[cell])) {
+			leg.start_node = cell;
+		}
+		else {
+			leg.start_node = -1;
+			back_node = cell - steps_to_node(cell, (dir + 2) % 4) * offset;
+		}
+
+		// Identify segment by the smaller of its two ends as node and
+		// direction into the segment
+		leg.segment = std::min(4LL * back_node + dir, 4LL * leg.end_node + (dir + 2) % 4);
+
+		++cart.leg_id;
+
+		// Check against carts sharing cells with this leg
+		check_bucket(id, segment_legs[leg.segment]);
+
+		if (leg.start_node != -1) {
+			check_bucket(id, node_legs[leg.start_node]);
+		}
+
+		check_bucket(id, node_legs[leg.end_node]);
+
+		segment_legs[leg.segment].emplace_back(id, cart.leg_id);
+
+		if (leg.start_node != -1) {
+			node_legs[leg.start_node].emplace_back(id, cart.leg_id);
+		}
+
+		node_legs[leg.end_node].emplace_back(id, cart.leg_id);
+
+		events.push(Event{ leg.t_end, kind_node, 0, id, cart.leg_id });
+	}
+
+	// Check leg of cart id against the legs in bucket, removing stale
+	// entries
+	void check_bucket(int id, std::vector<std::pair<int, int>> &bucket)
+	{
+		std::size_t num_valid = 0;
+
+		for (auto [other, leg_id] : bucket) {
+			if (!carts[other].alive || carts[other].leg_id != leg_id) {
+				continue;
+			}
+
+			bucket[num_valid++] = { other, leg_id };
+
+			if (other != id) {
+				check_pair(id, other);
+			}
+		}
+
+		bucket.resize(num_valid);
+	}
+
+	// Find the first crash between the current legs of carts a and b, and
+	// add it to the event queue
+	void check_pair(int a, int b)
+	{
+		const Leg &la = carts[a].leg;
+		const Leg &lb = carts[b].leg;
+
+		int lo = std::max(la.t0, lb.t0) + 1;
+		int hi = std::min(la.t_end, lb.t_end);
+
+		Event best;
+		best.t = hi + 1;
+
+		// Mover moves at tick t into the cell the other cart is in after tick
+		// t - delay. With delay 1 the other has not moved yet, so mover
+		// must move first, and with delay 0 the other must move first.
+		auto check = [&](int mover, const Leg &lm, const Leg &lother, int delay) {
+			long long c = dx[lm.dir] - dx[lother.dir];
+			long long rx = lother.x0 - lm.x0 + static_cast<long long>(dx[lm.dir]) * lm.t0
+			             - static_cast<long long>(dx[lother.dir]) * (delay + lother.t0);
+			long long cy = dy[lm.dir] - dy[lother.dir];
+			long long ry = lother.y0 - lm.y0 + static_cast<long long>(dy[lm.dir]) * lm.t0
+			             - static_cast<long long>(dy[lother.dir]) * (delay + lother.t0);
+
+			Solution sol = intersect(solve_linear(c, rx), solve_linear(cy, ry));
+
+			if (!sol.any) {
+				return;
+			}
+
+			// If every tick solves it, the carts move in parallel
+			// and their order does not change, so try the first
+			int t = sol.all ? lo : sol.t;
+
+			if (t < lo || t > hi || t > best.t) {
+				return;
+			}
+
+			int mover_key = key(lm, t - 1);
+			bool mover_first = mover_key < key(lother, t - 1);
+
+			if (mover_first != (delay == 1)) {
+				return;
+			}
+
+			if (t < best.t || mover_key < best.key) {
+				best = Event{ t, kind_crash, mover_key, mover, carts[mover].leg_id };
+			}
+		};
+
+		check(a, la, lb, 1);
+		check(b, lb, la, 0);
+		check(b, lb, la, 1);
+		check(a, la, lb, 0);
+
+		if (best.t <= hi) {
+			events.push(best);
+		}
+	}
+
+	void reach_node(const Event &ev)
+	{
+		Cart &cart = carts[ev.cart];
+
+		if (!cart.alive || cart.leg_id != ev.leg_id) {
+			return;
+		}
+
+		auto [x, y] = position(cart.leg, ev.t);
+
+		int dir = cart.leg.dir;
+
+		switch (track[y * width + x]) {
+		case '/':
+			dir ^= 1;
+			break;
+		case '\\':
+			dir = 3 - dir;
+			break;
+		case '+':
+			dir = (dir + 3 + cart.next_dir) % 4;
+			cart.next_dir = (cart.next_dir + 1) % 3;
+			break;
+		default:
+			break;
+		}
+
+		start_leg(ev.cart, ev.t, x, y, dir);
+	}
+
+	// Handle crash of cart moving into the cell of another cart. The
+	// crash event does not record the other cart, since it may be gone
+	// now, so find it among the carts sharing the cell
+	void crash(const Event &ev)
+	{
+		Cart &mover = carts[ev.cart];
+
+		if (!mover.alive || mover.leg_id != ev.leg_id) {
+			return;
+		}
+
+		auto [x, y] = position(mover.leg, ev.t);
+
+		int victim = find_victim(ev, x, y);
+
+		if (victim == -1) {
+			return;
+		}
+
+		if (num_alive == static_cast<int>(carts.size())) {
+			std::cout << "crash at " << x << ',' << y << '\n';
+		}
+
+		mover.alive = false;
+		carts[victim].alive = false;
+		num_alive -= 2;
+		last_crash_tick = ev.t;
+	}
+
+	// Find the cart occupying cell x, y when cart ev.cart moves there in
+	// tick ev.t, taking into account which of them moves first
+	int find_victim(const Event &ev, int x, int y)
+	{
+		const Leg &lm = carts[ev.cart].leg;
+
+		auto occupies = [&](int other) {
+			const Cart &cart = carts[other];
+
+			if (other == ev.cart || !cart.alive) {
+				return false;
+			}
+
+			const Leg &lo_ = cart.leg;
+
+			if (ev.t - 1 < lo_.t0 || ev.t > lo_.t_end) {
+				return false;
+			}
+
+			bool other_moved = key(lo_, ev.t - 1) < ev.key;
+
+			return position(lo_, other_moved ? ev.t : ev.t - 1) == std::make_pair(x, y);
+		};
+
+		for (auto [other, leg_id] : segment_legs[lm.segment]) {
+			if (carts[other].leg_id == leg_id && occupies(other)) {
+				return other;
+			}
+		}
+
+		for (int node : { lm.start_node, lm.end_node }) {
+			if (node == -1) {
+				continue;
+			}
+
+			for (auto [other, leg_id] : node_legs[node]) {
+				if (carts[other].leg_id == leg_id && occupies(other)) {
+					return other;
+				}
+			}
+		}
+
+		return -1;
+	}
+};
+
+int main()
+{
+	auto map = read_map();
+
+	Simulation sim(map);
+
+	std::cout << sim.num_carts() << " carts\n";
+
+	sim.run();
+
+	return 0;
+}
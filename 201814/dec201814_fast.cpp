@@ -0,0 +1,181 @@
+//
+// Advent of Code 2018, day 14, fast recipe generation
+//
+
+// Usage: dec201814_fast [NUM_RECIPES...]
+//
+// Generates the scoreboard with the plain loop from the solutions and with
+// a faster generator, checks that they produce the same scores, and prints
+// the time taken by each. Defaults to 10^8 and 10^9 recipes.
+//
+// Each elf moves at most ten places per step, while the scoreboard grows
+// by at least one recipe. So if the elf furthest along is d places from
+// the end, the next d / 10 steps cannot wrap around, and they are run as a
+// block without the modulo (a division on every step in the plain loop).
+// Once both elves end up near the end, single steps with a subtraction
+// take over until one of them has wrapped.
+//
+// After a short warm-up the elves walk the same positions, one trailing
+// the other, so most of the time the elf in front is far from the end and
+// blocks are long.
+//
+// Within a block, the digits appended for each sum 0 to 18 come from a
+// table, so the recipes are written without a branch on the sum.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+struct DigitTable {
+	std::uint8_t first[19] = {};
+	std::uint8_t second[19] = {};
+	std::uint8_t length[19] = {};
+
+	constexpr DigitTable()
+	{
+		for (int sum = 0; sum < 19; ++sum) {
+			first[sum] = static_cast<std::uint8_t>(sum > 9 ? 1 : sum);
+			second[sum] = static_cast<std::uint8_t>(sum > 9 ? sum - 10 : 0);
+			length[sum] = static_cast<std::uint8_t>(sum > 9 ? 2 : 1);
+		}
+	}
+};
+
+constexpr DigitTable digit_table;
+
+// Plain loop as in the solutions, with bytes instead of ints
+std::uint64_t generate_plain(std::uint8_t *scoreboard, std::uint64_t num_recipes)
+{
+	std::uint64_t size = 2;
+
+	scoreboard[0] = 3;
+	scoreboard[1] = 7;
+
+	std::uint64_t elf_a = 0;
+	std::uint64_t elf_b = 1;
+
+	while (size < num_recipes) {
+		int sum = scoreboard[elf_a] + scoreboard[elf_b];
+		if (sum > 9) {
+			scoreboard[size++] = static_cast<std::uint8_t>(sum / 10);
+			sum %= 10;
+		}
+		scoreboard[size++] = static_cast<std::uint8_t>(sum);
+
+		elf_a = (elf_a + scoreboard[elf_a] + 1) % size;
+		elf_b = (elf_b + scoreboard[elf_b] + 1) % size;
+	}
+
+	return size;
+}
+
+// Scoreboard must have room for num_recipes + 2 scores
+std::uint64_t generate_fast(std::uint8_t *scoreboard, std::uint64_t num_recipes)
+{
+	std::uint64_t size = 2;
+
+	scoreboard[0] = 3;
+	scoreboard[1] = 7;
+
+	std::uint64_t elf_a = 0;
+	std::uint64_t elf_b = 1;
+
+	while (size < num_recipes) {
+		std::uint64_t ahead = std::max(elf_a, elf_b);
+
+		// Number of steps neither elf can wrap in, limited so the
+		// scoreboard does not grow past num_recipes + 1
+		std::uint64_t num_steps = (size - 1 - ahead) / 10;
+
+		num_steps = std::min(num_steps, (num_recipes - size + 1) / 2);
+
+		if (num_steps == 0) {
+			int score_a = scoreboard[elf_a];
+			int score_b = scoreboard[elf_b];
+			int sum = score_a + score_b;
+
+			scoreboard[size] = digit_table.first[sum];
+			scoreboard[size + 1] = digit_table.second[sum];
+			size += digit_table.length[sum];
+
+			elf_a += score_a + 1;
+			elf_b += score_b + 1;
+
+			while (elf_a >= size) {
+				elf_a -= size;
+			}
+			while (elf_b >= size) {
+				elf_b -= size;
+			}
+
+			continue;
+		}
+
+		for (std::uint64_t i = 0; i < num_steps; ++i) {
+			int score_a = scoreboard[elf_a];
+			int score_b = scoreboard[elf_b];
+			int sum = score_a + score_b;
+
+			scoreboard[size] = digit_table.first[sum];
+			scoreboard[size + 1] = digit_table.second[sum];
+			size += digit_table.length[sum];
+
+			elf_a += score_a + 1;
+			elf_b += score_b + 1;
+		}
+	}
+
+	return size;
+}
+
+template<typename Fn>
+double time_ms(Fn fn)
+{
+	auto start = std::chrono::steady_clock::now();
+	fn();
+	auto end = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+	std::vector<std::uint64_t> sizes;
+
+	for (int i = 1; i < argc; ++i) {
+		sizes.push_back(std::strtoull(argv[i], nullptr, 10));
+	}
+
+	if (sizes.empty()) {
+		sizes = { 100000000ULL, 1000000000ULL };
+	}
+
+	for (std::uint64_t num_recipes : sizes) {
+		num_recipes = std::max<std::uint64_t>(num_recipes, 2);
+
+		std::unique_ptr<std::uint8_t[]> plain(new std::uint8_t[num_recipes + 2]);
+		std::unique_ptr<std::uint8_t[]> fast(new std::uint8_t[num_recipes + 2]);
+
+		std::uint64_t size_plain = 0;
+		std::uint64_t size_fast = 0;
+
+		double ms_plain = time_ms([&] { size_plain = generate_plain(plain.get(), num_recipes); });
+		double ms_fast = time_ms([&] { size_fast = generate_fast(fast.get(), num_recipes); });
+
+		bool same = std::memcmp(plain.get(), fast.get(), num_recipes) == 0;
+
+		std::cout << num_recipes << " recipes: plain " << ms_plain << " ms, fast "
+		          << ms_fast << " ms, " << (same ? "identical" : "MISMATCH") << '\n';
+
+		if (!same) {
+			exit(1);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,232 @@
+//
+// Advent of Code 2018, day 14, part two for any number of targets
+//
+
+// Usage: dec201814_search TARGET...
+//
+// Finds the number of recipes to the left of the first occurrence of each
+// of the digit sequences given on the command line, which may be of any
+// length and may start with zero.
+//
+// The scores are stored as 4-bit nibbles in a buffer allocated up front
+// for max_recipes scores, which is under 1 GB for 2 * 10^9 recipes. The
+// buffer is not initialized, so memory is only touched as recipes are
+// added.
+//
+// New digits are fed to an Aho-Corasick automaton built from the targets,
+// so all targets are matched in a single pass over the scores.
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <string>
+#include <vector>
+
+constexpr std::uint64_t max_recipes = 2000000000ULL;
+
+class Scoreboard {
+public:
+	explicit Scoreboard(std::uint64_t capacity) : nibbles(new std::uint8_t[capacity / 2 + 1]), capacity(capacity) {}
+
+	std::uint64_t size() const { return num_scores; }
+
+	bool full() const { return num_scores + 2 > capacity; }
+
+	int operator[](std::uint64_t i) const
+	{
+		return (nibbles[i / 2] >> (4 * (i % 2))) & 0x0F;
+	}
+
+	void push_back(int score)
+	{
+		std::uint8_t &byte = nibbles[num_scores / 2];
+
+		if (num_scores % 2 == 0) {
+			byte = static_cast<std::uint8_t>(score);
+		}
+		else {
+			byte |= static_cast<std::uint8_t>(score << 4);
+		}
+
+		++num_scores;
+	}
+
+private:
+	std::unique_ptr<std::uint8_t[]> nibbles;
+	std::uint64_t capacity = 0;
+	std::uint64_t num_scores = 0;
+};
+
+class Matcher {
+public:
+	explicit Matcher(const std::vector<std::string> &targets)
+	{
+		add_state();
+
+		for (int id = 0; id < targets.size(); ++id) {
+			int state = 0;
+
+			for (char ch : targets[id]) {
+				int digit = ch - '0';
+
+				if (next[state][digit] == -1) {
+					next[state][digit] = add_state();
+				}
+
+				state = next[state][digit];
+			}
+
+			output[state].push_back(id);
+		}
+
+		build_links();
+	}
+
+	// Advance by digit, returning the targets that end here
+	const std::vector<int> &feed(int digit)
+	{
+		state = next[state][digit];
+		return output[state];
+	}
+
+private:
+	std::vector<std::array<int, 10>> next;
+	std::vector<std::vector<int>> output;
+	int state = 0;
+
+	int add_state()
+	{
+		std::array<int, 10> none;
+		none.fill(-1);
+		next.push_back(none);
+		output.emplace_back();
+
+		return static_cast<int>(next.size() - 1);
+	}
+
+	// Compute failure links in BFS order and turn the trie into a full
+	// transition table, merging outputs along failure links
+	void build_links()
+	{
+		std::vector<int> fail(next.size(), 0);
+		std::queue<int> queue;
+
+		for (int digit = 0; digit < 10; ++digit) {
+			if (next[0][digit] == -1) {
+				next[0][digit] = 0;
+			}
+			else {
+				queue.push(next[0][digit]);
+			}
+		}
+
+		while (!queue.empty()) {
+			int s = queue.front();
+			queue.pop();
+
+			output[s].insert(output[s].end(), output[fail[s]].begin(), output[fail[s]].end());
+
+			for (int digit = 0; digit < 10; ++digit) {
+				int t = next[s][digit];
+
+				if (t == -1) {
+					next[s][digit] = next[fail[s]][digit];
+				}
+				else {
+					fail[t] = next[fail[s]][digit];
+					queue.push(t);
+				}
+			}
+		}
+	}
+};
+
+int main(int argc, char *argv[])
+{
+	std::vector<std::string> targets;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string target = argv[i];
+
+		if (target.empty() || target.find_first_not_of("0123456789") != std::string::npos) {
+			std::cerr << "target '" << target << "' is not a digit sequence\n";
+			exit(1);
+		}
+
+		targets.push_back(target);
+	}
+
+	if (targets.empty()) {
+		std::cerr << "usage: dec201814_search TARGET...\n";
+		exit(1);
+	}
+
+	Matcher matcher(targets);
+
+	std::vector<std::int64_t> found(targets.size(), -1);
+	std::size_t num_found = 0;
+
+	Scoreboard scoreboard(max_recipes);
+
+	std::uint64_t checked = 0;
+
+	auto check_new = [&]() {
+		for (; checked < scoreboard.size(); ++checked) {
+			for (int id : matcher.feed(scoreboard[checked])) {
+				if (found[id] == -1) {
+					found[id] = static_cast<std::int64_t>(checked + 1 - targets[id].size());
+					++num_found;
+				}
+			}
+		}
+	};
+
+	scoreboard.push_back(3);
+	scoreboard.push_back(7);
+
+	std::uint64_t elf_a = 0;
+	std::uint64_t elf_b = 1;
+
+	check_new();
+
+	while (num_found < targets.size() && !scoreboard.full()) {
+		int score_a = scoreboard[elf_a];
+		int score_b = scoreboard[elf_b];
+		int sum = score_a + score_b;
+
+		if (sum > 9) {
+			scoreboard.push_back(sum / 10);
+			sum %= 10;
+		}
+		scoreboard.push_back(sum);
+
+		elf_a += score_a + 1;
+		elf_b += score_b + 1;
+
+		// The elves move at most ten places, so a subtraction suffices
+		// once there are more than ten scores
+		while (elf_a >= scoreboard.size()) {
+			elf_a -= scoreboard.size();
+		}
+		while (elf_b >= scoreboard.size()) {
+			elf_b -= scoreboard.size();
+		}
+
+		check_new();
+	}
+
+	for (std::size_t id = 0; id < targets.size(); ++id) {
+		std::cout << targets[id] << ": ";
+
+		if (found[id] == -1) {
+			std::cout << "not found in " << scoreboard.size() << " recipes\n";
+		}
+		else {
+			std::cout << found[id] << '\n';
+		}
+	}
+
+	return 0;
+}
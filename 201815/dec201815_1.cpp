@@ -30,26 +30,14 @@
 // part two.
 
 #include <algorithm>
+#include <array>
 #include <iostream>
+#include <limits>
 #include <numeric>
-#include <queue>
 #include <string>
-#include <tuple>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
-struct PairHash {
-	template<typename T1, typename T2>
-	std::size_t operator()(const std::pair<T1, T2> &p) const noexcept
-	{
-		std::size_t h1 = std::hash<T1>()(p.first);
-		std::size_t h2 = std::hash<T2>()(p.second);
-
-		return (17 * 37 + h1) * 37 + h2;
-	}
-};
-
 struct Unit {
 	int y = 0;
 	int x = 0;
@@ -93,81 +81,137 @@ bool is_enemy_adjacant(const std::vector<std::string> &map, const Unit &unit, in
 	    || map[y + 1][x] == enemy_type;
 }
 
-std::pair<int, int> find_best_move(const std::vector<std::string> &map, const Unit &unit)
+// Buffers for find_best_move, indexed by y * width + x and reused between
+// searches. A cell has been visited in the current search if its stamp
+// equals epoch, so nothing needs to be cleared between searches. Each cell
+// is queued at most once per search, so the frontier never wraps.
+struct SearchBuffers {
+	int width = 0;
+	int epoch = 0;
+	std::vector<int> stamp;
+	std::vector<int> parent;
+	std::vector<int> dist;
+	std::vector<int> frontier;
+
+	explicit SearchBuffers(const std::vector<std::string> &map)
+		: width(static_cast<int>(map.front().size())),
+		  stamp(map.size() * map.front().size(), 0),
+		  parent(stamp.size()),
+		  dist(stamp.size()),
+		  frontier(stamp.size())
+	{
+	}
+
+	void next_epoch()
+	{
+		if (++epoch == std::numeric_limits<int>::max()) {
+			std::fill(stamp.begin(), stamp.end(), 0);
+			epoch = 1;
+		}
+	}
+};
+
+std::pair<int, int> find_best_move(const std::vector<std::string> &map, const Unit &unit, SearchBuffers &buf)
 {
-	std::queue<std::tuple<int, int, int>> queue;
+	const int width = buf.width;
+	const int offsets[4] = { -width, -1, 1, width };
+
+	buf.next_epoch();
 
-	std::unordered_map<std::pair<int, int>, std::pair<int, int>, PairHash> prev;
+	int start = unit.y * width + unit.x;
+	int head = 0;
+	int tail = 0;
 
-	queue.push({unit.x, unit.y, 0});
-	prev[{unit.x, unit.y}] = {-1, -1};
+	buf.frontier[tail++] = start;
+	buf.stamp[start] = buf.epoch;
+	buf.parent[start] = -1;
+	buf.dist[start] = 0;
 
-	std::vector<std::pair<int, int>> nearest;
+	int nearest = -1;
 	int nearest_dist = std::numeric_limits<int>::max();
 
-	while (!queue.empty()) {
-		auto [x, y, dist] = queue.front();
-		queue.pop();
+	while (head < tail) {
+		int cell = buf.frontier[head++];
+		int dist = buf.dist[cell];
 
 		if (dist > nearest_dist) {
 			break;
 		}
 
+		int x = cell % width;
+		int y = cell / width;
+
+		// Keep the nearest position first in reading order, which
+		// is the one with the lowest index
 		if (is_enemy_adjacant(map, unit, x, y)) {
-			nearest.push_back({y, x});
+			if (nearest == -1 || cell < nearest) {
+				nearest = cell;
+			}
 			nearest_dist = dist;
 			continue;
 		}
 
 		// Continue search in NWES order so backtracking finds the
 		// correct first move
-		if (map[y - 1][x] == '.') {
-			if (auto [it, success] = prev.insert({{x, y - 1}, {x, y}}); success) {
-				queue.push({x, y - 1, dist + 1});
+		for (int offset : offsets) {
+			int next = cell + offset;
+
+			if (map[next / width][next % width] == '.' && buf.stamp[next] != buf.epoch) {
+				buf.stamp[next] = buf.epoch;
+				buf.parent[next] = cell;
+				buf.dist[next] = dist + 1;
+				buf.frontier[tail++] = next;
 			}
 		}
+	}
 
-		if (map[y][x - 1] == '.') {
-			if (auto [it, success] = prev.insert({{x - 1, y}, {x, y}}); success) {
-				queue.push({x - 1, y, dist + 1});
-			}
-		}
+	if (nearest != -1) {
+		// Backtrack from first nearest in reading order
+		int cell = nearest;
 
-		if (map[y][x + 1] == '.') {
-			if (auto [it, success] = prev.insert({{x + 1, y}, {x, y}}); success) {
-				queue.push({x + 1, y, dist + 1});
-			}
+		while (buf.parent[cell] != start) {
+			cell = buf.parent[cell];
 		}
 
-		if (map[y + 1][x] == '.') {
-			if (auto [it, success] = prev.insert({{x, y + 1}, {x, y}}); success) {
-				queue.push({x, y + 1, dist + 1});
-			}
-		}
+		return {cell % width, cell / width};
 	}
 
-	if (!nearest.empty()) {
-		std::sort(nearest.begin(), nearest.end());
+	return {-1, -1};
+}
+
+// Index into units of the unit at each square, or -1, kept in step with
+// map, along with the number of elves and goblins alive
+struct UnitIndex {
+	int width = 0;
+	std::vector<int> at;
+	int num_elves = 0;
+	int num_goblins = 0;
 
-		// Backtrack from first nearest in reading order
-		auto [y, x] = nearest.front();
+	explicit UnitIndex(const std::vector<std::string> &map)
+		: width(static_cast<int>(map.front().size())),
+		  at(map.size() * map.front().size(), -1)
+	{
+	}
 
-		for (;;) {
-			auto [prev_x, prev_y] = prev[{x, y}];
+	// Reindex after units were sorted or dead units removed
+	void rebuild(const std::vector<Unit> &units)
+	{
+		std::fill(at.begin(), at.end(), -1);
 
-			if (prev_x == unit.x && prev_y == unit.y) {
-				return {x, y};
-			}
+		num_elves = 0;
+		num_goblins = 0;
 
-			x = prev_x;
-			y = prev_y;
+		for (int i = 0; i < units.size(); ++i) {
+			if (units[i].type != 'X') {
+				at[units[i].y * width + units[i].x] = i;
+				num_elves += static_cast<int>(units[i].type == 'E');
+				num_goblins += static_cast<int>(units[i].type == 'G');
+			}
 		}
 	}
+};
 
-	return {-1, -1};
-}
-
-void perform_move(std::vector<std::string> &map, Unit &unit)
+void perform_move(std::vector<std::string> &map, UnitIndex &index, Unit &unit, SearchBuffers &buf)
 {
 	if (unit.type == 'X') {
 		return;
@@ -177,31 +221,38 @@ void perform_move(std::vector<std::string> &map, Unit &unit)
 		return;
 	}
 
-	auto [x, y] = find_best_move(map, unit);
+	auto [x, y] = find_best_move(map, unit, buf);
 
 	if (x != -1) {
 		map[unit.y][unit.x] = '.';
 
+		int i = index.at[unit.y * index.width + unit.x];
+		index.at[unit.y * index.width + unit.x] = -1;
+
 		unit.x = x;
 		unit.y = y;
 
 		map[unit.y][unit.x] = unit.type;
+
+		index.at[unit.y * index.width + unit.x] = i;
 	}
 }
 
-std::vector<Unit>::iterator find_alive_unit_at(std::vector<Unit> &units, int x, int y)
+std::vector<Unit>::iterator find_alive_unit_at(std::vector<Unit> &units, const UnitIndex &index, int x, int y)
 {
-	return std::find_if(units.begin(), units.end(), [&](const Unit &unit) { return unit.type != 'X' && unit.x == x && unit.y == y; });
+	int i = index.at[y * index.width + x];
+
+	return i == -1 ? units.end() : units.begin() + i;
 }
 
-std::vector<Unit>::iterator find_best_enemy(std::vector<Unit> &units, const Unit &unit)
+std::vector<Unit>::iterator find_best_enemy(std::vector<Unit> &units, const UnitIndex &index, const Unit &unit)
 {
-	std::vector<std::vector<Unit>::iterator> enemies;
-
-	enemies.push_back(find_alive_unit_at(units, unit.x, unit.y - 1));
-	enemies.push_back(find_alive_unit_at(units, unit.x - 1, unit.y));
-	enemies.push_back(find_alive_unit_at(units, unit.x + 1, unit.y));
-	enemies.push_back(find_alive_unit_at(units, unit.x, unit.y + 1));
+	std::array<std::vector<Unit>::iterator, 4> enemies = {
+		find_alive_unit_at(units, index, unit.x, unit.y - 1),
+		find_alive_unit_at(units, index, unit.x - 1, unit.y),
+		find_alive_unit_at(units, index, unit.x + 1, unit.y),
+		find_alive_unit_at(units, index, unit.x, unit.y + 1)
+	};
 
 	int lowest_hp = std::numeric_limits<int>::max();
 	auto best_enemy = units.end();
@@ -218,7 +269,7 @@ std::vector<Unit>::iterator find_best_enemy(std::vector<Unit> &units, const Unit
 	return best_enemy;
 }
 
-void perform_attack(std::vector<std::string> &map, std::vector<Unit> &units, Unit &unit)
+void perform_attack(std::vector<std::string> &map, std::vector<Unit> &units, UnitIndex &index, Unit &unit)
 {
 	if (unit.type == 'X') {
 		return;
@@ -228,7 +279,7 @@ void perform_attack(std::vector<std::string> &map, std::vector<Unit> &units, Uni
 		return;
 	}
 
-	auto enemy = find_best_enemy(units, unit);
+	auto enemy = find_best_enemy(units, index, unit);
 
 	if (enemy == units.end()) {
 		return;
@@ -237,22 +288,18 @@ void perform_attack(std::vector<std::string> &map, std::vector<Unit> &units, Uni
 	enemy->hp -= 3;
 
 	if (enemy->hp <= 0) {
+		index.num_elves -= static_cast<int>(enemy->type == 'E');
+		index.num_goblins -= static_cast<int>(enemy->type == 'G');
+		index.at[enemy->y * index.width + enemy->x] = -1;
+
 		enemy->type = 'X';
 		map[enemy->y][enemy->x] = '.';
 	}
 }
 
-bool no_enemies_left(const std::vector<Unit> &units)
+bool no_enemies_left(const UnitIndex &index)
 {
-	int num_elfs = 0;
-	int num_goblins = 0;
-
-	for (const auto &unit : units) {
-		num_elfs += static_cast<int>(unit.type == 'E');
-		num_goblins += static_cast<int>(unit.type == 'G');
-	}
-
-	return num_elfs == 0 || num_goblins == 0;
+	return index.num_elves == 0 || index.num_goblins == 0;
 }
 
 int main()
@@ -269,19 +316,24 @@ int main()
 		}
 	}
 
+	SearchBuffers buf(map);
+	UnitIndex index(map);
+
 	bool done = false;
 
 	for (int round = 0; !done; ++round) {
 		std::sort(units.begin(), units.end());
 
+		index.rebuild(units);
+
 		for (auto &unit : units) {
-			if (no_enemies_left(units)) {
+			if (no_enemies_left(index)) {
 				done = true;
 				break;
 			}
 
-			perform_move(map, unit);
-			perform_attack(map, units, unit);
+			perform_move(map, index, unit, buf);
+			perform_attack(map, units, index, unit);
 		}
 
 		// Remove dead units
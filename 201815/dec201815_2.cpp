@@ -3,26 +3,17 @@
 //
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <iostream>
+#include <limits>
+#include <mutex>
 #include <numeric>
-#include <queue>
 #include <string>
-#include <tuple>
-#include <unordered_map>
+#include <thread>
 #include <utility>
 #include <vector>
 
-struct PairHash {
-	template<typename T1, typename T2>
-	std::size_t operator()(const std::pair<T1, T2> &p) const noexcept
-	{
-		std::size_t h1 = std::hash<T1>()(p.first);
-		std::size_t h2 = std::hash<T2>()(p.second);
-
-		return (17 * 37 + h1) * 37 + h2;
-	}
-};
-
 struct Unit {
 	int y = 0;
 	int x = 0;
@@ -67,81 +58,137 @@ bool is_enemy_adjacant(const std::vector<std::string> &map, const Unit &unit, in
 	    || map[y + 1][x] == enemy_type;
 }
 
-std::pair<int, int> find_best_move(const std::vector<std::string> &map, const Unit &unit)
+// Buffers for find_best_move, indexed by y * width + x and reused between
+// searches. A cell has been visited in the current search if its stamp
+// equals epoch, so nothing needs to be cleared between searches. Each cell
+// is queued at most once per search, so the frontier never wraps.
+struct SearchBuffers {
+	int width = 0;
+	int epoch = 0;
+	std::vector<int> stamp;
+	std::vector<int> parent;
+	std::vector<int> dist;
+	std::vector<int> frontier;
+
+	explicit SearchBuffers(const std::vector<std::string> &map)
+		: width(static_cast<int>(map.front().size())),
+		  stamp(map.size() * map.front().size(), 0),
+		  parent(stamp.size()),
+		  dist(stamp.size()),
+		  frontier(stamp.size())
+	{
+	}
+
+	void next_epoch()
+	{
+		if (++epoch == std::numeric_limits<int>::max()) {
+			std::fill(stamp.begin(), stamp.end(), 0);
+			epoch = 1;
+		}
+	}
+};
+
+std::pair<int, int> find_best_move(const std::vector<std::string> &map, const Unit &unit, SearchBuffers &buf)
 {
-	std::queue<std::tuple<int, int, int>> queue;
+	const int width = buf.width;
+	const int offsets[4] = { -width, -1, 1, width };
+
+	buf.next_epoch();
 
-	std::unordered_map<std::pair<int, int>, std::pair<int, int>, PairHash> prev;
+	int start = unit.y * width + unit.x;
+	int head = 0;
+	int tail = 0;
 
-	queue.push({unit.x, unit.y, 0});
-	prev[{unit.x, unit.y}] = {-1, -1};
+	buf.frontier[tail++] = start;
+	buf.stamp[start] = buf.epoch;
+	buf.parent[start] = -1;
+	buf.dist[start] = 0;
 
-	std::vector<std::pair<int, int>> nearest;
+	int nearest = -1;
 	int nearest_dist = std::numeric_limits<int>::max();
 
-	while (!queue.empty()) {
-		auto [x, y, dist] = queue.front();
-		queue.pop();
+	while (head < tail) {
+		int cell = buf.frontier[head++];
+		int dist = buf.dist[cell];
 
 		if (dist > nearest_dist) {
 			break;
 		}
 
+		int x = cell % width;
+		int y = cell / width;
+
+		// Keep the nearest position first in reading order, which
+		// is the one with the lowest index
 		if (is_enemy_adjacant(map, unit, x, y)) {
-			nearest.push_back({y, x});
+			if (nearest == -1 || cell < nearest) {
+				nearest = cell;
+			}
 			nearest_dist = dist;
 			continue;
 		}
 
 		// Continue search in NWES order so backtracking finds the
 		// correct first move
-		if (map[y - 1][x] == '.') {
-			if (auto [it, success] = prev.insert({{x, y - 1}, {x, y}}); success) {
-				queue.push({x, y - 1, dist + 1});
+		for (int offset : offsets) {
+			int next = cell + offset;
+
+			if (map[next / width][next % width] == '.' && buf.stamp[next] != buf.epoch) {
+				buf.stamp[next] = buf.epoch;
+				buf.parent[next] = cell;
+				buf.dist[next] = dist + 1;
+				buf.frontier[tail++] = next;
 			}
 		}
+	}
 
-		if (map[y][x - 1] == '.') {
-			if (auto [it, success] = prev.insert({{x - 1, y}, {x, y}}); success) {
-				queue.push({x - 1, y, dist + 1});
-			}
-		}
+	if (nearest != -1) {
+		// Backtrack from first nearest in reading order
+		int cell = nearest;
 
-		if (map[y][x + 1] == '.') {
-			if (auto [it, success] = prev.insert({{x + 1, y}, {x, y}}); success) {
-				queue.push({x + 1, y, dist + 1});
-			}
+		while (buf.parent[cell] != start) {
+			cell = buf.parent[cell];
 		}
 
-		if (map[y + 1][x] == '.') {
-			if (auto [it, success] = prev.insert({{x, y + 1}, {x, y}}); success) {
-				queue.push({x, y + 1, dist + 1});
-			}
-		}
+		return {cell % width, cell / width};
 	}
 
-	if (!nearest.empty()) {
-		std::sort(nearest.begin(), nearest.end());
+	return {-1, -1};
+}
+
+// Index into units of the unit at each square, or -1, kept in step with
+// map, along with the number of elves and goblins alive
+struct UnitIndex {
+	int width = 0;
+	std::vector<int> at;
+	int num_elves = 0;
+	int num_goblins = 0;
 
-		// Backtrack from first nearest in reading order
-		auto [y, x] = nearest.front();
+	explicit UnitIndex(const std::vector<std::string> &map)
+		: width(static_cast<int>(map.front().size())),
+		  at(map.size() * map.front().size(), -1)
+	{
+	}
 
-		for (;;) {
-			auto [prev_x, prev_y] = prev[{x, y}];
+	// Reindex after units were sorted or dead units removed
+	void rebuild(const std::vector<Unit> &units)
+	{
+		std::fill(at.begin(), at.end(), -1);
 
-			if (prev_x == unit.x && prev_y == unit.y) {
-				return {x, y};
-			}
+		num_elves = 0;
+		num_goblins = 0;
 
-			x = prev_x;
-			y = prev_y;
+		for (int i = 0; i < units.size(); ++i) {
+			if (units[i].type != 'X') {
+				at[units[i].y * width + units[i].x] = i;
+				num_elves += static_cast<int>(units[i].type == 'E');
+				num_goblins += static_cast<int>(units[i].type == 'G');
+			}
 		}
 	}
+};
 
-	return {-1, -1};
-}
-
-void perform_move(std::vector<std::string> &map, Unit &unit)
+void perform_move(std::vector<std::string> &map, UnitIndex &index, Unit &unit, SearchBuffers &buf)
 {
 	if (unit.type == 'X') {
 		return;
@@ -151,31 +198,38 @@ void perform_move(std::vector<std::string> &map, Unit &unit)
 		return;
 	}
 
-	auto [x, y] = find_best_move(map, unit);
+	auto [x, y] = find_best_move(map, unit, buf);
 
 	if (x != -1) {
 		map[unit.y][unit.x] = '.';
 
+		int i = index.at[unit.y * index.width + unit.x];
+		index.at[unit.y * index.width + unit.x] = -1;
+
 		unit.x = x;
 		unit.y = y;
 
 		map[unit.y][unit.x] = unit.type;
+
+		index.at[unit.y * index.width + unit.x] = i;
 	}
 }
 
-std::vector<Unit>::iterator find_alive_unit_at(std::vector<Unit> &units, int x, int y)
+std::vector<Unit>::iterator find_alive_unit_at(std::vector<Unit> &units, const UnitIndex &index, int x, int y)
 {
-	return std::find_if(units.begin(), units.end(), [&](const Unit &unit) { return unit.type != 'X' && unit.x == x && unit.y == y; });
+	int i = index.at[y * index.width + x];
+
+	return i == -1 ? units.end() : units.begin() + i;
 }
 
-std::vector<Unit>::iterator find_best_enemy(std::vector<Unit> &units, const Unit &unit)
+std::vector<Unit>::iterator find_best_enemy(std::vector<Unit> &units, const UnitIndex &index, const Unit &unit)
 {
-	std::vector<std::vector<Unit>::iterator> enemies;
-
-	enemies.push_back(find_alive_unit_at(units, unit.x, unit.y - 1));
-	enemies.push_back(find_alive_unit_at(units, unit.x - 1, unit.y));
-	enemies.push_back(find_alive_unit_at(units, unit.x + 1, unit.y));
-	enemies.push_back(find_alive_unit_at(units, unit.x, unit.y + 1));
+	std::array<std::vector<Unit>::iterator, 4> enemies = {
+		find_alive_unit_at(units, index, unit.x, unit.y - 1),
+		find_alive_unit_at(units, index, unit.x - 1, unit.y),
+		find_alive_unit_at(units, index, unit.x + 1, unit.y),
+		find_alive_unit_at(units, index, unit.x, unit.y + 1)
+	};
 
 	int lowest_hp = std::numeric_limits<int>::max();
 	auto best_enemy = units.end();
@@ -192,72 +246,123 @@ std::vector<Unit>::iterator find_best_enemy(std::vector<Unit> &units, const Unit
 	return best_enemy;
 }
 
-void perform_attack(std::vector<std::string> &map, std::vector<Unit> &units, Unit &unit)
+// Returns true if unit attacked
+bool perform_attack(std::vector<std::string> &map, std::vector<Unit> &units, UnitIndex &index, Unit &unit)
 {
 	if (unit.type == 'X') {
-		return;
+		return false;
 	}
 
 	if (!has_enemy_in_range(map, unit)) {
-		return;
+		return false;
 	}
 
-	auto enemy = find_best_enemy(units, unit);
+	auto enemy = find_best_enemy(units, index, unit);
 
 	if (enemy == units.end()) {
-		return;
+		return false;
 	}
 
 	enemy->hp -= unit.ap;
 
 	if (enemy->hp <= 0) {
+		index.num_elves -= static_cast<int>(enemy->type == 'E');
+		index.num_goblins -= static_cast<int>(enemy->type == 'G');
+		index.at[enemy->y * index.width + enemy->x] = -1;
+
 		enemy->type = 'X';
 		map[enemy->y][enemy->x] = '.';
 	}
+
+	return true;
 }
 
-bool no_enemies_left(const std::vector<Unit> &units)
+bool no_enemies_left(const UnitIndex &index)
 {
-	int num_elfs = 0;
-	int num_goblins = 0;
-
-	for (const auto &unit : units) {
-		num_elfs += static_cast<int>(unit.type == 'E');
-		num_goblins += static_cast<int>(unit.type == 'G');
-	}
-
-	return num_elfs == 0 || num_goblins == 0;
+	return index.num_elves == 0 || index.num_goblins == 0;
 }
 
-std::pair<int, bool> simulate_combat(std::vector<std::string> map, int elf_ap)
-{
+// State of combat at the start of a round
+struct Combat {
+	std::vector<std::string> map;
 	std::vector<Unit> units;
-
+	int round = 0;
 	int num_elves = 0;
+};
+
+Combat start_combat(const std::vector<std::string> &map)
+{
+	Combat combat;
+
+	combat.map = map;
 
 	for (int y = 0; y < map.size(); ++y) {
 		for (int x = 0; x < map[y].size(); ++x) {
 			if (map[y][x] == 'G' || map[y][x] == 'E') {
-				units.push_back(Unit{y, x, 200, map[y][x] == 'E' ? elf_ap : 3, map[y][x]});
+				combat.units.push_back(Unit{y, x, 200, 3, map[y][x]});
 
-				num_elves += static_cast<int>(map[y][x] == 'E');
+				combat.num_elves += static_cast<int>(map[y][x] == 'E');
 			}
 		}
 	}
 
+	return combat;
+}
+
+// Simulate combat from state until it ends, an elf dies, or a winning AP
+// lower than elf_ap is found.
+//
+// If fork is not null, the state at the start of each round is saved
+// there, and the simulation stops when an elf first attacks. Everything
+// before that is the same for any elf AP, so other AP values can start
+// from the saved state instead of from the beginning.
+std::pair<int, bool> simulate_combat(Combat combat, int elf_ap, const std::atomic<int> &best_ap, Combat *fork = nullptr)
+{
+	auto &map = combat.map;
+	auto &units = combat.units;
+	const int num_elves = combat.num_elves;
+
+	for (auto &unit : units) {
+		if (unit.type == 'E') {
+			unit.ap = elf_ap;
+		}
+	}
+
+	SearchBuffers buf(map);
+	UnitIndex index(map);
+
 	bool done = false;
 
-	for (int round = 0; !done; ++round) {
+	for (int round = combat.round; !done; ++round) {
+		if (elf_ap > best_ap.load(std::memory_order_relaxed)) {
+			return {-1, false};
+		}
+
+		if (fork != nullptr) {
+			combat.round = round;
+			*fork = combat;
+		}
+
 		std::sort(units.begin(), units.end());
 
+		index.rebuild(units);
+
 		for (auto &unit : units) {
-			if (no_enemies_left(units)) {
+			if (no_enemies_left(index)) {
 				done = true;
 				break;
 			}
 
-			perform_move(map, unit);
-			perform_attack(map, units, unit);
+			perform_move(map, index, unit, buf);
+
+			if (perform_attack(map, units, index, unit) && unit.type == 'E' && fork != nullptr) {
+				return {-1, false};
+			}
+
+			// No need to continue once an elf has died
+			if (index.num_elves < num_elves) {
+				return {-1, false};
+			}
 		}
 
 		// Remove dead units
@@ -272,7 +377,7 @@ std::pair<int, bool> simulate_combat(std::vector<std::string> map, int elf_ap)
 					return acc + unit.hp;
 				});
 
-			return {round * total_hp, units.front().type == 'E' && units.size() == num_elves};
+			return {round * total_hp, units.front().type == 'E' && units.size() == static_cast<std::size_t>(num_elves)};
 		}
 	}
 
@@ -289,14 +394,57 @@ int main()
 	//
 	// It turns out they do not win for every AP value above the first,
 	// so we do a linear search instead.
-	for (int elf_ap = 4; ; ++elf_ap) {
-		auto [outcome, elves_won] = simulate_combat(map, elf_ap);
+	//
+	// The search is spread over threads that take AP values in increasing
+	// order. Once an AP is found where the elves win, simulations of
+	// higher AP values are abandoned, while lower ones run to the end, so
+	// the result is the same as the linear search.
+	//
+	// All simulations start from the round where an elf first attacks,
+	// since the combat is the same for every AP until then.
+	std::atomic<int> next_ap = 4;
+	std::atomic<int> best_ap = std::numeric_limits<int>::max();
+	int best_outcome = 0;
+	std::mutex best_mutex;
 
-		if (elves_won) {
-			std::cout << "with AP " << elf_ap << " elves won with outcome " << outcome << '\n';
-			break;
+	Combat fork;
+
+	simulate_combat(start_combat(map), 3, best_ap, &fork);
+
+	auto worker = [&]() {
+		for (;;) {
+			int elf_ap = next_ap.fetch_add(1);
+
+			if (elf_ap > best_ap.load()) {
+				break;
+			}
+
+			auto [outcome, elves_won] = simulate_combat(fork, elf_ap, best_ap);
+
+			if (elves_won) {
+				std::lock_guard<std::mutex> lock(best_mutex);
+
+				if (elf_ap < best_ap.load()) {
+					best_ap.store(elf_ap);
+					best_outcome = outcome;
+				}
+			}
 		}
+	};
+
+	unsigned int num_threads = std::max(1U, std::thread::hardware_concurrency());
+
+	std::vector<std::thread> threads;
+
+	for (unsigned int i = 0; i < num_threads; ++i) {
+		threads.emplace_back(worker);
 	}
 
+	for (auto &thread : threads) {
+		thread.join();
+	}
+
+	std::cout << "with AP " << best_ap << " elves won with outcome " << best_outcome << '\n';
+
 	return 0;
 }
@@ -2,127 +2,39 @@
 // Advent of Code 2018, day 16, part two
 //
 
-#include <array>
+#include "dec201816_samples.h"
+#include "../elfcode/elfcode.h"
+
+#include <algorithm>
 #include <cstdint>
-#include <cstdio>
+#include <cstdlib>
 #include <iostream>
+#include <iterator>
+#include <string>
 #include <vector>
 
-using Registers = std::array<unsigned int, 4>;
-
-struct Instruction {
-	int opcode = -1;
-	unsigned int a = 0;
-	unsigned int b = 0;
-	unsigned int c = 0;
-};
-
-struct Sample {
-	Registers before = {};
-	Instruction ins;
-	Registers after = {};
-};
-
-using Program = std::vector<Instruction>;
-
-std::vector<Sample> read_samples()
-{
-	std::vector<Sample> samples;
-	Registers before;
-	Registers after;
-	Instruction ins;
-
-	while (std::scanf("Before: [%u, %u, %u, %u] ", &before[0], &before[1], &before[2], &before[3]) == 4
-	    && std::scanf("%d %u %u %u ", &ins.opcode, &ins.a, &ins.b, &ins.c) == 4
-	    && std::scanf("After:  [%u, %u, %u, %u] ", &after[0], &after[1], &after[2], &after[3]) == 4) {
-		samples.push_back({before, ins, after});
-	}
-
-	return samples;
-}
-
-Program read_program()
+// Read the program that follows the samples, with the opcodes mapped to
+// the ones of the elfcode interpreter through lookup
+Program read_program(const std::string &text, std::size_t start, const std::vector<int> &lookup)
 {
 	Program program;
-	Instruction ins;
 
-	while (std::cin >> ins.opcode >> ins.a >> ins.b >> ins.c) {
-		program.push_back(ins);
-	}
+	const char *p = text.data() + start;
+	const char *end = text.data() + text.size();
 
-	return program;
-}
+	std::uint32_t v[4];
 
-Registers perform_instruction(int opcode, const Instruction &ins, Registers reg)
-{
-	switch (opcode) {
-	case 0: // addr
-		reg[ins.c] = reg[ins.a] + reg[ins.b];
-		break;
-	case 1: // addi
-		reg[ins.c] = reg[ins.a] + ins.b;
-		break;
-	case 2: // mulr
-		reg[ins.c] = reg[ins.a] * reg[ins.b];
-		break;
-	case 3: // muli
-		reg[ins.c] = reg[ins.a] * ins.b;
-		break;
-	case 4: // banr
-		reg[ins.c] = reg[ins.a] & reg[ins.b];
-		break;
-	case 5: // bani
-		reg[ins.c] = reg[ins.a] & ins.b;
-		break;
-	case 6: // borr
-		reg[ins.c] = reg[ins.a] | reg[ins.b];
-		break;
-	case 7: // bori
-		reg[ins.c] = reg[ins.a] | ins.b;
-		break;
-	case 8: // setr
-		reg[ins.c] = reg[ins.a];
-		break;
-	case 9: // seti
-		reg[ins.c] = ins.a;
-		break;
-	case 10: // gtir
-		reg[ins.c] = static_cast<unsigned int>(ins.a > reg[ins.b]);
-		break;
-	case 11: // gtri
-		reg[ins.c] = static_cast<unsigned int>(reg[ins.a] > ins.b);
-		break;
-	case 12: // gtrr
-		reg[ins.c] = static_cast<unsigned int>(reg[ins.a] > reg[ins.b]);
-		break;
-	case 13: // eqir
-		reg[ins.c] = static_cast<unsigned int>(ins.a == reg[ins.b]);
-		break;
-	case 14: // eqri
-		reg[ins.c] = static_cast<unsigned int>(reg[ins.a] == ins.b);
-		break;
-	case 15: // eqrr
-		reg[ins.c] = static_cast<unsigned int>(reg[ins.a] == reg[ins.b]);
-		break;
-	default:
-		std::cerr << "unknown opcode " << opcode << '\n';
-		exit(1);
-		break;
-	}
-
-	return reg;
-}
-
-constexpr int count_bits_set(std::uint32_t v)
-{
-	int count = 0;
+	while (next_number(p, end, v[0]) && next_number(p, end, v[1])
+	    && next_number(p, end, v[2]) && next_number(p, end, v[3])) {
+		if (v[0] >= lookup.size() || lookup[v[0]] < 0) {
+			std::cerr << "unknown opcode " << v[0] << '\n';
+			exit(1);
+		}
 
-	while (v != 0) {
-		v &= v - 1;
-		++count;
+		program.push_back(Instruction{lookup[v[0]], v[1], v[2], v[3]});
 	}
 
-	return count;
+	return program;
 }
 
 constexpr int lowest_bit_set(std::uint32_t v)
@@ -170,37 +82,37 @@ std::vector<int> opcode_lookup_from_possibilities(std::vector<std::uint32_t> pos
 
 int main()
 {
-	auto samples = read_samples();
+	std::string text = read_input();
+	std::size_t end = 0;
+
+	auto samples = read_samples(text, end);
 
 	std::cout << samples.size() << " samples read\n";
 
 	std::vector<std::uint32_t> possibilities(16, 0);
 
-	for (const auto &sample : samples) {
-		std::uint32_t mask = 0;
+	auto masks = candidate_masks(samples);
 
-		for (int opcode = 0; opcode < 16; ++opcode) {
-			if (perform_instruction(opcode, sample.ins, sample.before) == sample.after) {
-				mask |= 1U << opcode;
-			}
+	for (std::size_t i = 0; i < samples.size(); ++i) {
+		if (samples.opcode[i] >= possibilities.size()) {
+			std::cerr << "unknown opcode " << samples.opcode[i] << '\n';
+			exit(1);
 		}
 
-		possibilities[sample.ins.opcode] |= mask;
+		possibilities[samples.opcode[i]] |= masks[i];
 	}
 
-	auto opcode_lookup = opcode_lookup_from_possibilities(possibilities);
-
-	auto program = read_program();
+	auto program = read_program(text, end, opcode_lookup_from_possibilities(possibilities));
 
 	std::cout << program.size() << " instructions read\n";
 
-	Registers reg = {};
+	// The program has no jumps, so there is no register bound to the
+	// instruction pointer
+	Computer computer(program, -1);
 
-	for (const auto &ins : program) {
-		reg = perform_instruction(opcode_lookup[ins.opcode], ins, reg);
-	}
+	computer.run();
 
-	std::cout << "register 0 = " << reg[0] << '\n';
+	std::cout << "register 0 = " << computer.registers()[0] << '\n';
 
 	return 0;
 }
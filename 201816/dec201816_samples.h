@@ -0,0 +1,253 @@
+//
+// Advent of Code 2018, day 16, reading and checking the samples, shared by
+// parts one and two
+//
+
+#ifndef DEC201816_SAMPLES_H
+#define DEC201816_SAMPLES_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Samples stored by field, one column for each register before and after
+// and for each part of the instruction, so each opcode is checked against
+// many samples in a loop the compiler vectorizes (build with -O3
+// -march=native to get AVX2 or AVX-512)
+struct Samples {
+	std::array<std::vector<std::uint32_t>, 4> before;
+	std::vector<std::uint32_t> opcode;
+	std::vector<std::uint32_t> a;
+	std::vector<std::uint32_t> b;
+	std::vector<std::uint32_t> c;
+	std::array<std::vector<std::uint32_t>, 4> after;
+
+	std::size_t size() const { return opcode.size(); }
+
+	void append(const Samples &other)
+	{
+		auto add = [](std::vector<std::uint32_t> &to, const std::vector<std::uint32_t> &from) {
+			to.insert(to.end(), from.begin(), from.end());
+		};
+
+		for (int r = 0; r < 4; ++r) {
+			add(before[r], other.before[r]);
+			add(after[r], other.after[r]);
+		}
+
+		add(opcode, other.opcode);
+		add(a, other.a);
+		add(b, other.b);
+		add(c, other.c);
+	}
+};
+
+inline std::string read_input()
+{
+	std::string text;
+	char buffer[1 << 16];
+	std::size_t n = 0;
+
+	while ((n = std::fread(buffer, 1, sizeof(buffer), stdin)) > 0) {
+		text.append(buffer, n);
+	}
+
+	return text;
+}
+
+// Parse the next number at or after p, returning false if there is none
+inline bool next_number(const char *&p, const char *end, std::uint32_t &value)
+{
+	while (p != end && (*p < '0' || *p > '9')) {
+		++p;
+	}
+
+	if (p == end) {
+		return false;
+	}
+
+	value = 0;
+
+	while (p != end && *p >= '0' && *p <= '9') {
+		value = value * 10 + static_cast<std::uint32_t>(*p - '0');
+		++p;
+	}
+
+	return true;
+}
+
+// Parse the samples in [p, end), twelve numbers each
+inline void parse_samples(const char *p, const char *end, Samples &samples)
+{
+	std::uint32_t v[12];
+
+	while (next_number(p, end, v[0])) {
+		for (int i = 1; i < 12; ++i) {
+			if (!next_number(p, end, v[i])) {
+				std::cerr << "incomplete sample\n";
+				exit(1);
+			}
+		}
+
+		for (int r = 0; r < 4; ++r) {
+			samples.before[r].push_back(v[r]);
+			samples.after[r].push_back(v[8 + r]);
+		}
+
+		samples.opcode.push_back(v[4]);
+		samples.a.push_back(v[5]);
+		samples.b.push_back(v[6]);
+		samples.c.push_back(v[7]);
+	}
+}
+
+// Read the samples at the start of text, up to the end of the line with
+// the last "After:", returning that position in end. The text is split
+// at "Before:" lines into one piece per thread, parsed in parallel.
+inline Samples read_samples(const std::string &text, std::size_t &end)
+{
+	std::size_t last_after = text.rfind("After:");
+
+	end = last_after == std::string::npos ? 0 : std::min(text.find('\n', last_after), text.size());
+
+	unsigned int num_threads = std::max(1U, std::thread::hardware_concurrency());
+
+	std::vector<std::size_t> bounds = { 0 };
+
+	for (unsigned int t = 1; t < num_threads; ++t) {
+		std::size_t pos = std::min(text.find("Before:", end / num_threads * t), end);
+
+		if (pos > bounds.back()) {
+			bounds.push_back(pos);
+		}
+	}
+
+	bounds.push_back(end);
+
+	std::vector<Samples> parts(bounds.size() - 1);
+	std::vector<std::thread> threads;
+
+	for (std::size_t i = 0; i + 1 < bounds.size(); ++i) {
+		threads.emplace_back([&, i] {
+			parse_samples(text.data() + bounds[i], text.data() + bounds[i + 1], parts[i]);
+		});
+	}
+
+	for (auto &thread : threads) {
+		thread.join();
+	}
+
+	Samples samples;
+
+	for (const auto &part : parts) {
+		samples.append(part);
+	}
+
+	return samples;
+}
+
+// Mask of the opcodes each sample behaves like, bit n for opcode n.
+//
+// The registers other than c must be the same before and after whatever
+// the opcode, so that is checked once per sample, along with looking up
+// the registers the operands name. Then each opcode is a loop over the
+// samples comparing its result with register c after. A register
+// operand above 3 does not match.
+inline std::vector<std::uint32_t> candidate_masks(const Samples &samples)
+{
+	constexpr std::size_t batch = 1024;
+
+	const std::size_t n = samples.size();
+
+	std::vector<std::uint32_t> masks(n, 0);
+
+	// For one batch, the registers named by a and b, register c after,
+	// and 1 if the sample can match an opcode reading the registers
+	// given by the suffix, else 0
+	std::array<std::uint32_t, batch> reg_a;
+	std::array<std::uint32_t, batch> reg_b;
+	std::array<std::uint32_t, batch> expected;
+	std::array<std::uint32_t, batch> ok_rr;
+	std::array<std::uint32_t, batch> ok_ri;
+	std::array<std::uint32_t, batch> ok_ir;
+	std::array<std::uint32_t, batch> ok_ii;
+
+	for (std::size_t first = 0; first < n; first += batch) {
+		const std::size_t m = std::min(batch, n - first);
+
+		const std::uint32_t *b0 = &samples.before[0][first];
+		const std::uint32_t *b1 = &samples.before[1][first];
+		const std::uint32_t *b2 = &samples.before[2][first];
+		const std::uint32_t *b3 = &samples.before[3][first];
+		const std::uint32_t *a0 = &samples.after[0][first];
+		const std::uint32_t *a1 = &samples.after[1][first];
+		const std::uint32_t *a2 = &samples.after[2][first];
+		const std::uint32_t *a3 = &samples.after[3][first];
+		const std::uint32_t *a = &samples.a[first];
+		const std::uint32_t *b = &samples.b[first];
+		const std::uint32_t *c = &samples.c[first];
+		std::uint32_t *mask = &masks[first];
+
+		for (std::size_t i = 0; i < m; ++i) {
+			reg_a[i] = a[i] == 0 ? b0[i] : a[i] == 1 ? b1[i] : a[i] == 2 ? b2[i] : b3[i];
+			reg_b[i] = b[i] == 0 ? b0[i] : b[i] == 1 ? b1[i] : b[i] == 2 ? b2[i] : b3[i];
+			expected[i] = c[i] == 0 ? a0[i] : c[i] == 1 ? a1[i] : c[i] == 2 ? a2[i] : a3[i];
+
+			// Bitwise rather than logical operators, so there are no
+			// branches to stop vectorization
+			std::uint32_t same = static_cast<std::uint32_t>(
+				((c[i] == 0) | (b0[i] == a0[i])) & ((c[i] == 1) | (b1[i] == a1[i]))
+			  & ((c[i] == 2) | (b2[i] == a2[i])) & ((c[i] == 3) | (b3[i] == a3[i])) & (c[i] < 4));
+
+			ok_ii[i] = same;
+			ok_ri[i] = same & static_cast<std::uint32_t>(a[i] < 4);
+			ok_ir[i] = same & static_cast<std::uint32_t>(b[i] < 4);
+			ok_rr[i] = ok_ri[i] & ok_ir[i];
+		}
+
+		auto check = [&](int opcode, const std::array<std::uint32_t, batch> &ok, auto result) {
+			for (std::size_t i = 0; i < m; ++i) {
+				mask[i] |= (ok[i] & static_cast<std::uint32_t>(result(i) == expected[i])) << opcode;
+			}
+		};
+
+		check(0, ok_rr, [&](std::size_t i) { return reg_a[i] + reg_b[i]; }); // addr
+		check(1, ok_ri, [&](std::size_t i) { return reg_a[i] + b[i]; }); // addi
+		check(2, ok_rr, [&](std::size_t i) { return reg_a[i] * reg_b[i]; }); // mulr
+		check(3, ok_ri, [&](std::size_t i) { return reg_a[i] * b[i]; }); // muli
+		check(4, ok_rr, [&](std::size_t i) { return reg_a[i] & reg_b[i]; }); // banr
+		check(5, ok_ri, [&](std::size_t i) { return reg_a[i] & b[i]; }); // bani
+		check(6, ok_rr, [&](std::size_t i) { return reg_a[i] | reg_b[i]; }); // borr
+		check(7, ok_ri, [&](std::size_t i) { return reg_a[i] | b[i]; }); // bori
+		check(8, ok_ri, [&](std::size_t i) { return reg_a[i]; }); // setr
+		check(9, ok_ii, [&](std::size_t i) { return a[i]; }); // seti
+		check(10, ok_ir, [&](std::size_t i) { return static_cast<std::uint32_t>(a[i] > reg_b[i]); }); // gtir
+		check(11, ok_ri, [&](std::size_t i) { return static_cast<std::uint32_t>(reg_a[i] > b[i]); }); // gtri
+		check(12, ok_rr, [&](std::size_t i) { return static_cast<std::uint32_t>(reg_a[i] > reg_b[i]); }); // gtrr
+		check(13, ok_ir, [&](std::size_t i) { return static_cast<std::uint32_t>(a[i] == reg_b[i]); }); // eqir
+		check(14, ok_ri, [&](std::size_t i) { return static_cast<std::uint32_t>(reg_a[i] == b[i]); }); // eqri
+		check(15, ok_rr, [&](std::size_t i) { return static_cast<std::uint32_t>(reg_a[i] == reg_b[i]); }); // eqrr
+	}
+
+	return masks;
+}
+
+constexpr int count_bits_set(std::uint32_t v)
+{
+	int count = 0;
+
+	while (v != 0) {
+		v &= v - 1;
+		++count;
+	}
+
+	return count;
+}
+
+#endif // DEC201816_SAMPLES_H
@@ -2,10 +2,40 @@
 // Advent of Code 2018, day 17, part one and two
 //
 
+// Usage: dec201817_1 [--pgm FILE] < input.txt
+//
+// With --pgm, the map at the end is written to FILE as a binary PGM
+// image, one pixel per square: white for sand, black for clay, light grey
+// for flowing water and dark grey for water at rest.
+//
+// The map only covers the columns from min_x - 1 to max_x + 1, where
+// water can go, and stores each square in two bits. It is split into
+// tiles of 32 x 32 squares, with each row of a tile in one 64-bit word,
+// so water falling down a column stays in one small block of memory for
+// 32 rows rather than touching a new cache line on every row.
+//
+// Water is followed as a stack of drops, each a stream falling from a
+// spill point (the spring for the first). A drop falls until it lands on
+// something solid, then looks along that row both ways for walls. If the
+// row has an edge water can fall over, a new drop is started there and
+// the row is looked at again once that drop is done. A row with clay at
+// both ends fills with water at rest, and the drop goes on with the row
+// above. A row with an open side is left as flowing water, and so is the
+// rest of the drop's stream.
+//
+// Flowing water is only ever left on squares whose water is known to
+// flow away, so a drop that falls onto flowing water, or a row that runs
+// into it, stops there without going over that part again. Each row is
+// filled once, and the time taken grows with the number of wet squares
+// rather than with how many ways there are to reach them.
+
 #include <algorithm>
+#include <cstdint>
 #include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
-#include <queue>
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -32,13 +62,213 @@ std::vector<Vein> read_veins()
 	return veins;
 }
 
-bool solid_below(const std::vector<std::string> &map, int x, int y)
+enum class Cell : std::uint8_t { sand, clay, flowing, settled };
+
+class Grid {
+public:
+	static constexpr int tile_size = 32;
+
+	// Squares with x from x0 to x0 + width - 1 and y from 0 to height - 1
+	Grid(int x0_, int width_, int height_)
+	 : x0(x0_), width(width_), height(height_),
+	   tiles_per_row((width_ + tile_size - 1) / tile_size),
+	   words(static_cast<std::size_t>(tiles_per_row) * ((height_ + tile_size - 1) / tile_size) * tile_size, 0) {}
+
+	Cell get(int x, int y) const
+	{
+		int shift = 0;
+		std::size_t i = index(x, y, shift);
+
+		return static_cast<Cell>((words[i] >> shift) & 3);
+	}
+
+	void set(int x, int y, Cell cell)
+	{
+		int shift = 0;
+		std::size_t i = index(x, y, shift);
+
+		words[i] = (words[i] & ~(std::uint64_t(3) << shift)) | (static_cast<std::uint64_t>(cell) << shift);
+	}
+
+	// Number of squares with water, flowing or at rest, and with water at
+	// rest, in rows first_y to last_y
+	void count_water(int first_y, int last_y, int &num_wet, int &num_settled) const;
+
+	void write_pgm(std::ostream &os) const;
+
+private:
+	int x0 = 0;
+	int width = 0;
+	int height = 0;
+	int tiles_per_row = 0;
+	std::vector<std::uint64_t> words;
+
+	std::size_t index(int x, int y, int &shift) const
+	{
+		int col = x - x0;
+
+		shift = 2 * (col % tile_size);
+
+		return (static_cast<std::size_t>(y / tile_size) * tiles_per_row + col / tile_size) * tile_size + y % tile_size;
+	}
+};
+
+void Grid::count_water(int first_y, int last_y, int &num_wet, int &num_settled) const
 {
-	return map[y + 1][x] == '#' || map[y + 1][x] == '~';
+	// Water sets the high bit of a square, water at rest both bits
+	constexpr std::uint64_t high = 0xaaaaaaaaaaaaaaaaULL;
+
+	num_wet = 0;
+	num_settled = 0;
+
+	for (std::size_t i = 0; i < words.size(); ++i) {
+		int y = static_cast<int>(i / (static_cast<std::size_t>(tiles_per_row) * tile_size)) * tile_size + static_cast<int>(i % tile_size);
+
+		if (y < first_y || y > last_y) {
+			continue;
+		}
+
+		std::uint64_t w = words[i];
+
+		num_wet += __builtin_popcountll(w & high);
+		num_settled += __builtin_popcountll(w & (w << 1) & high);
+	}
 }
 
-int main()
+void Grid::write_pgm(std::ostream &os) const
+{
+	static const unsigned char shade[] = { 255, 0, 192, 96 };
+
+	os << "P5\n" << width << ' ' << height << "\n255\n";
+
+	std::vector<unsigned char> row(width);
+
+	for (int y = 0; y < height; ++y) {
+		for (int x = 0; x < width; ++x) {
+			row[x] = shade[static_cast<int>(get(x0 + x, y))];
+		}
+
+		os.write(reinterpret_cast<const char *>(row.data()), width);
+	}
+}
+
+// Stream of water falling from (x, top), with y the row it is filling
+struct Drop {
+	int x = 0;
+	int top = 0;
+	int y = 0;
+};
+
+// How a row of water ends on one side
+enum class Edge { wall, open, spill };
+
+// Follow the row at y from x in direction dx, returning how it ends, with
+// end the last square of the row on that side
+Edge follow_row(const Grid &map, int x, int y, int dx, int &end)
 {
+	for (;;) {
+		Cell below = map.get(x, y + 1);
+
+		if (below == Cell::sand) {
+			end = x;
+			return Edge::spill;
+		}
+
+		if (below == Cell::flowing) {
+			end = x;
+			return Edge::open;
+		}
+
+		Cell next = map.get(x + dx, y);
+
+		if (next == Cell::clay) {
+			end = x;
+			return Edge::wall;
+		}
+
+		if (next == Cell::flowing) {
+			end = x;
+			return Edge::open;
+		}
+
+		x += dx;
+	}
+}
+
+void fill(Grid &map, int spring_x, int max_y)
+{
+	// The spring's drop falls from the row above the map, so that water
+	// filling up to row 1 spreads on row 0 like on any other row
+	std::vector<Drop> drops = { Drop{spring_x, -1, -1} };
+
+	// Whether the drop on top of the stack is new and has to fall first
+	bool falling = true;
+
+	while (!drops.empty()) {
+		Drop &drop = drops.back();
+
+		if (falling) {
+			falling = false;
+
+			while (drop.y < max_y && map.get(drop.x, drop.y + 1) == Cell::sand) {
+				++drop.y;
+				map.set(drop.x, drop.y, Cell::flowing);
+			}
+
+			// Off the bottom of the map, or onto water known to flow away
+			if (drop.y == max_y || map.get(drop.x, drop.y + 1) == Cell::flowing) {
+				drops.pop_back();
+				continue;
+			}
+		}
+
+		int l = drop.x;
+		int r = drop.x;
+
+		Edge left = follow_row(map, drop.x, drop.y, -1, l);
+		Edge right = follow_row(map, drop.x, drop.y, 1, r);
+
+		if (left == Edge::spill || right == Edge::spill) {
+			// The row is looked at again when this one is done
+			int x = left == Edge::spill ? l : r;
+
+			drops.push_back(Drop{x, drop.y, drop.y});
+			falling = true;
+			continue;
+		}
+
+		if (left == Edge::wall && right == Edge::wall) {
+			for (int x = l; x <= r; ++x) {
+				map.set(x, drop.y, Cell::settled);
+			}
+
+			// Filled up to where the drop came from, so the row that
+			// one was on has to be looked at again
+			if (--drop.y == drop.top) {
+				drops.pop_back();
+			}
+
+			continue;
+		}
+
+		for (int x = l; x <= r; ++x) {
+			map.set(x, drop.y, Cell::flowing);
+		}
+
+		drops.pop_back();
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	std::string pgm_name;
+
+	for (int i = 1; i < argc; ++i) {
+		if (std::string(argv[i]) == "--pgm" && i + 1 < argc) {
+			pgm_name = argv[++i];
+		}
+	}
+
 	auto veins = read_veins();
 
 	int min_x = std::numeric_limits<int>::max();
@@ -53,92 +283,45 @@ int main()
 		max_y = std::max(max_y, vein.second.second);
 	}
 
-	std::vector<std::string> map;
+	if (veins.empty()) {
+		std::cerr << "no veins read\n";
+		exit(1);
+	}
 
-	map.reserve(max_y + 1);
+	// Water can spill one square past the outermost clay on either side,
+	// and the spring must be on the map too
+	int x0 = std::min(min_x, 500) - 1;
+	int x1 = std::max(max_x, 500) + 1;
 
-	for (int y = 0; y <= max_y; ++y) {
-		// max_x + 2 in case something spills over the right edge
-		map.emplace_back(max_x + 2, '.');
-	}
+	Grid map(x0, x1 - x0 + 1, max_y + 1);
 
 	for (const auto &vein : veins) {
 		auto [x_range, y_range] = vein;
 
 		for (int y = y_range.first; y <= y_range.second; ++y) {
 			for (int x = x_range.first; x <= x_range.second; ++x) {
-				map[y][x] = '#';
+				map.set(x, y, Cell::clay);
 			}
 		}
 	}
 
-	std::queue<std::pair<int, int>> queue;
-
-	map[0][500] = '+';
-	queue.push({500, 0});
-
-	while (!queue.empty()) {
-		auto [x, y] = queue.front();
-		queue.pop();
-
-		// Move down until we hit something solid
-		while (y < max_y && !solid_below(map, x, y)) {
-			++y;
-			map[y][x] = '|';
-		}
-
-		if (y == max_y) {
-			continue;
-		}
+	fill(map, 500, max_y);
 
-		int l = x;
-		int r = x;
+	if (!pgm_name.empty()) {
+		std::ofstream out(pgm_name, std::ios::binary);
 
-		// Find left edge, filling with wet sand
-		while (map[y][l - 1] != '#') {
-			--l;
-			map[y][l] = '|';
+		map.write_pgm(out);
 
-			if (!solid_below(map, l, y)) {
-				queue.push({l, y});
-				break;
-			}
- 		}
-
-		// Find right edge, filling with wet sand
-		while (map[y][r + 1] != '#') {
-			++r;
-			map[y][r] = '|';
-
-			if (!solid_below(map, r, y)) {
-				queue.push({r, y});
-				break;
-			}
- 		}
-
-		// If both sides are clay, fill with water and continue one
-		// line up
-		if (map[y][l - 1] == '#' && map[y][r + 1] == '#') {
-			for (int i = l; i <= r; ++i) {
-				map[y][i] = '~';
-			}
-			queue.push({x, y - 1});
+		if (!out) {
+			std::cerr << "unable to write " << pgm_name << '\n';
+			exit(1);
 		}
 	}
 
-	for (const auto &line : map) {
-		std::cout << line.substr(min_x - 1) << '\n';
-	}
-
 	int num_wet_tiles = 0;
 	int num_water = 0;
 
-	for (int y = min_y; y <= max_y; ++y) {
-		for (char ch : map[y]) {
-			num_wet_tiles += static_cast<int>(ch == '|' || ch == '~');
-			num_water += static_cast<int>(ch == '~');
-		}
-	}
+	map.count_water(min_y, max_y, num_wet_tiles, num_water);
 
 	std::cout << num_wet_tiles << '\n';
 	std::cout << num_water << '\n';
@@ -0,0 +1,896 @@
+//
+// Advent of Code 2018, day 17, water after editing the veins of clay
+//
+
+// Usage: dec201817_edit [--check] [--repeat N] VEINS_FILE < edits.txt
+//
+// Reads the veins from VEINS_FILE, fills the ground with water as in the
+// solution, and prints the number of wet squares and of squares with
+// water at rest. Then reads edits from stdin, one per line, a vein in the
+// same form as in the scan with + in front to add it or - to remove it:
+//
+//     + x=495, y=2..7
+//     - y=13, x=498..504
+//
+// and prints the counts again after each.
+//
+// Only the water that depends on the squares an edit changes is filled
+// again. The fill is the stack of drops from the solution, where each drop
+// is a stream falling from a spill point (see dec201817_1.cpp), and each
+// drop records the rectangles of squares it read and wrote. An edit finds
+// the drops that read any of the squares it changed, removes the water
+// written by each of them and by the drops it started, and runs it again
+// from its spill point. If that leaves different water on squares other
+// drops read, those drops are run again too, and so on. A drop's own
+// spill point is on the row of the drop that started it, which reads the
+// squares below that row, so when the outcome of a drop changes, the drop
+// that started it is run again as well. Drops are run again in the order
+// they were first started, so a drop is never run again after the drop
+// that started it has replaced it.
+//
+// The drops replaced and the records of squares read by earlier runs of a
+// drop are left in place, and cleared out after an edit once they make up
+// half of what is kept, so a long series of edits does not slow down.
+//
+// Edits that move the bounds of the scan (a vein beyond the outermost
+// ones, or removing an outermost one) change which squares are counted or
+// where water leaves the bottom, and fill everything again. Removing the
+// last vein leaves an empty scan with no water, and the next vein added
+// fills from that.
+//
+// With --check, each edit is also applied by filling from scratch, and
+// the two maps are compared.
+//
+// With --repeat, the edits are applied N times over, and only a line for
+// each time through them is printed, with the total and slowest time and
+// the number of drops and records kept. For edits that put the veins
+// back as they were, like adding and then removing the same veins, these
+// should stay about the same from one time to the next.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <string>
+#include <vector>
+
+using Vein = std::pair<std::pair<int, int>, std::pair<int, int>>;
+
+bool parse_vein(const std::string &line, Vein &vein)
+{
+	int first_coord = 0;
+	int second_coord_first = 0;
+	int second_coord_last = 0;
+	char first_axis = 'x';
+	char second_axis = 'y';
+
+	if (std::sscanf(line.c_str(), " %c=%d, %c=%d..%d", &first_axis, &first_coord, &second_axis, &second_coord_first, &second_coord_last) != 5) {
+		return false;
+	}
+
+	if (first_axis == 'x') {
+		vein = {{first_coord, first_coord}, {second_coord_first, second_coord_last}};
+	}
+	else {
+		vein = {{second_coord_first, second_coord_last}, {first_coord, first_coord}};
+	}
+
+	return true;
+}
+
+enum class Cell : std::uint8_t { sand, clay, flowing, settled };
+
+// Two bits per square in tiles of 32 x 32, as in dec201817_1.cpp
+class Grid {
+public:
+	static constexpr int tile_size = 32;
+
+	// Squares with x from x0 to x0 + width - 1 and y from 0 to height - 1
+	Grid(int x0_, int width_, int height_)
+	 : x0(x0_), width(width_), height(height_),
+	   tiles_per_row((width_ + tile_size - 1) / tile_size),
+	   words(static_cast<std::size_t>(tiles_per_row) * ((height_ + tile_size - 1) / tile_size) * tile_size, 0) {}
+
+	Cell get(int x, int y) const
+	{
+		int shift = 0;
+		std::size_t i = index(x, y, shift);
+
+		return static_cast<Cell>((words[i] >> shift) & 3);
+	}
+
+	void set(int x, int y, Cell cell)
+	{
+		int shift = 0;
+		std::size_t i = index(x, y, shift);
+
+		words[i] = (words[i] & ~(std::uint64_t(3) << shift)) | (static_cast<std::uint64_t>(cell) << shift);
+	}
+
+	bool operator==(const Grid &other) const
+	{
+		return x0 == other.x0 && width == other.width && height == other.height && words == other.words;
+	}
+
+private:
+	int x0 = 0;
+	int width = 0;
+	int height = 0;
+	int tiles_per_row = 0;
+	std::vector<std::uint64_t> words;
+
+	std::size_t index(int x, int y, int &shift) const
+	{
+		int col = x - x0;
+
+		shift = 2 * (col % tile_size);
+
+		return (static_cast<std::size_t>(y / tile_size) * tiles_per_row + col / tile_size) * tile_size + y % tile_size;
+	}
+};
+
+struct Rect {
+	int x1 = 0;
+	int x2 = 0;
+	int y1 = 0;
+	int y2 = 0;
+
+	bool intersects(const Rect &other) const
+	{
+		return x1 <= other.x2 && other.x1 <= x2 && y1 <= other.y2 && other.y1 <= y2;
+	}
+};
+
+// Stream of water falling from (x, top), with y the row it is filling
+struct Drop {
+	int x = 0;
+	int top = 0;
+	int y = 0;
+
+	// Drop this one was started from, -1 for the spring, drops started
+	// from this one's rows, and whether it has been replaced by running
+	// one of those again
+	int parent = -1;
+	std::vector<int> children;
+	bool alive = true;
+
+	// Number of times run again, to tell which squares looked at are
+	// from the last run
+	int generation = 0;
+
+	// Squares water was put on
+	std::vector<Rect> writes;
+};
+
+// Squares looked at by a drop
+struct Read {
+	int id = 0;
+	int generation = 0;
+	Rect rect;
+};
+
+// How a row of water ends on one side
+enum class Edge { wall, open, spill };
+
+class Ground {
+public:
+	explicit Ground(const std::vector<Vein> &veins_);
+
+	// Apply an edit, returning the number of drops run again, or -1 if
+	// everything was filled again. A vein removed must be in the scan.
+	int edit(const Vein &vein, bool add);
+
+	bool has_vein(const Vein &vein) const
+	{
+		return std::find(vein_list.begin(), vein_list.end(), vein) != vein_list.end();
+	}
+
+	int num_wet() const { return wet; }
+	int num_settled() const { return settled; }
+
+	const std::vector<Vein> &veins() const { return vein_list; }
+
+	std::size_t num_drops() const { return drops.size(); }
+	std::size_t num_reads() const { return reads_kept; }
+
+	bool same_water(const Ground &other) const
+	{
+		return *map == *other.map && wet == other.wet && settled == other.settled;
+	}
+
+private:
+	static constexpr int band_size = 64;
+
+	std::vector<Vein> vein_list;
+
+	int x0 = 0;
+	int x1 = 0;
+	int min_y = 0;
+	int max_y = 0;
+
+	std::unique_ptr<Grid> map;
+
+	// The map as it was before the drops being run again started, kept
+	// up to date with map outside of run_again
+	std::unique_ptr<Grid> shadow;
+
+	int wet = 0;
+	int settled = 0;
+
+	std::vector<Drop> drops;
+
+	// Squares looked at, by band of rows, with each rectangle in every
+	// band it overlaps
+	std::vector<std::vector<Read>> bands;
+
+	// Records in bands, and the numbers of drops and records after the
+	// last compact
+	std::size_t reads_kept = 0;
+	std::size_t drops_compacted = 0;
+	std::size_t reads_compacted = 0;
+
+	// Drops waiting to be run again, first started first, and which
+	// drops are in there
+	std::priority_queue<int, std::vector<int>, std::greater<int>> pending;
+	std::vector<bool> queued;
+
+	bool bounds(const std::vector<Vein> &veins_, int &x0_, int &x1_, int &min_y_, int &max_y_) const;
+	void build();
+
+	void set(int x, int y, Cell cell)
+	{
+		Cell old = map->get(x, y);
+
+		if (y >= min_y && y <= max_y) {
+			wet += static_cast<int>(cell == Cell::flowing || cell == Cell::settled)
+			     - static_cast<int>(old == Cell::flowing || old == Cell::settled);
+			settled += static_cast<int>(cell == Cell::settled) - static_cast<int>(old == Cell::settled);
+		}
+
+		map->set(x, y, cell);
+	}
+
+	int new_drop(int parent, int x, int top)
+	{
+		Drop drop;
+		drop.x = x;
+		drop.top = top;
+		drop.y = top;
+		drop.parent = parent;
+
+		drops.push_back(drop);
+		queued.push_back(false);
+
+		return static_cast<int>(drops.size()) - 1;
+	}
+
+	void add_read(int id, const Rect &rect)
+	{
+		for (int b = rect.y1 / band_size; b <= rect.y2 / band_size && b < static_cast<int>(bands.size()); ++b) {
+			bands[b].push_back(Read{id, drops[id].generation, rect});
+			++reads_kept;
+		}
+	}
+
+	void compact();
+
+	Edge follow_row(int x, int y, int dx, int &end) const;
+
+	bool is_ancestor(int ancestor, int id) const
+	{
+		for (int p = drops[id].parent; p >= 0; p = drops[p].parent) {
+			if (p == ancestor) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// Call fn for each drop that read squares in rect
+	template<typename Fn>
+	void for_each_reader(const Rect &rect, Fn fn) const;
+
+	void run(int root);
+	int run_again(int id);
+
+	// Queue the drops that read squares in rect, other than those from
+	// first on and those set in skip
+	void invalidate(const Rect &rect, int first, const std::vector<bool> &skip);
+};
+
+bool Ground::bounds(const std::vector<Vein> &veins_, int &x0_, int &x1_, int &min_y_, int &max_y_) const
+{
+	if (veins_.empty()) {
+		return false;
+	}
+
+	int min_x = std::numeric_limits<int>::max();
+	int max_x = std::numeric_limits<int>::min();
+
+	min_y_ = std::numeric_limits<int>::max();
+	max_y_ = std::numeric_limits<int>::min();
+
+	for (const auto &vein : veins_) {
+		min_x = std::min(min_x, vein.first.first);
+		min_y_ = std::min(min_y_, vein.second.first);
+		max_x = std::max(max_x, vein.first.second);
+		max_y_ = std::max(max_y_, vein.second.second);
+	}
+
+	x0_ = std::min(min_x, 500) - 1;
+	x1_ = std::max(max_x, 500) + 1;
+
+	return true;
+}
+
+Ground::Ground(const std::vector<Vein> &veins_)
+ : vein_list(veins_)
+{
+	build();
+}
+
+void Ground::build()
+{
+	// A scan left empty by edits has no rows to count and no water
+	if (!bounds(vein_list, x0, x1, min_y, max_y)) {
+		x0 = 499;
+		x1 = 501;
+		min_y = 0;
+		max_y = -1;
+	}
+
+	map = std::make_unique<Grid>(x0, x1 - x0 + 1, max_y + 1);
+	wet = 0;
+	settled = 0;
+
+	for (const auto &vein : vein_list) {
+		auto [x_range, y_range] = vein;
+
+		for (int y = y_range.first; y <= y_range.second; ++y) {
+			for (int x = x_range.first; x <= x_range.second; ++x) {
+				map->set(x, y, Cell::clay);
+			}
+		}
+	}
+
+	drops.clear();
+	queued.clear();
+	bands.assign(max_y / band_size + 1, {});
+
+	reads_kept = 0;
+
+	// The spring's drop falls from the row above the map, so that water
+	// filling up to row 1 spreads on row 0 like on any other row
+	if (!vein_list.empty()) {
+		run(new_drop(-1, 500, -1));
+	}
+
+	shadow = std::make_unique<Grid>(*map);
+
+	drops_compacted = drops.size();
+	reads_compacted = reads_kept;
+}
+
+Edge Ground::follow_row(int x, int y, int dx, int &end) const
+{
+	for (;;) {
+		Cell below = map->get(x, y + 1);
+
+		if (below == Cell::sand) {
+			end = x;
+			return Edge::spill;
+		}
+
+		if (below == Cell::flowing) {
+			end = x;
+			return Edge::open;
+		}
+
+		Cell next = map->get(x + dx, y);
+
+		if (next == Cell::clay) {
+			end = x;
+			return Edge::wall;
+		}
+
+		if (next == Cell::flowing) {
+			end = x;
+			return Edge::open;
+		}
+
+		x += dx;
+	}
+}
+
+// The fill from dec201817_1.cpp, recording what each drop reads and writes
+void Ground::run(int root)
+{
+	std::vector<int> stack = { root };
+
+	// Whether the drop on top of the stack is new and has to fall first
+	bool falling = true;
+
+	while (!stack.empty()) {
+		int id = stack.back();
+		int x = drops[id].x;
+		int y = drops[id].y;
+
+		if (falling) {
+			falling = false;
+
+			int top = y;
+
+			while (y < max_y && map->get(x, y + 1) == Cell::sand) {
+				++y;
+				set(x, y, Cell::flowing);
+			}
+
+			drops[id].y = y;
+
+			if (y > top) {
+				drops[id].writes.push_back(Rect{x, x, top + 1, y});
+			}
+
+			add_read(id, Rect{x, x, top + 1, std::min(y + 1, max_y)});
+
+			// Off the bottom of the map, or onto water known to flow away.
+			// A drop run again can also find something solid right below
+			// its spill point, put there by another drop run again. Then
+			// it is replaced when the drop that started it runs again,
+			// as the square below that one's row has changed.
+			if (y == max_y || map->get(x, y + 1) == Cell::flowing || (y == top && drops[id].parent >= 0)) {
+				stack.pop_back();
+				continue;
+			}
+		}
+
+		int l = x;
+		int r = x;
+
+		Edge left = follow_row(x, y, -1, l);
+		Edge right = follow_row(x, y, 1, r);
+
+		add_read(id, Rect{l - 1, r + 1, y, y + 1});
+
+		if (left == Edge::spill || right == Edge::spill) {
+			// The row is looked at again when this one is done
+			int child = new_drop(id, left == Edge::spill ? l : r, y);
+
+			drops[id].children.push_back(child);
+			stack.push_back(child);
+			falling = true;
+			continue;
+		}
+
+		Cell cell = left == Edge::wall && right == Edge::wall ? Cell::settled : Cell::flowing;
+
+		for (int i = l; i <= r; ++i) {
+			set(i, y, cell);
+		}
+
+		drops[id].writes.push_back(Rect{l, r, y, y});
+
+		// Filled up to where the drop came from, so the row that one was
+		// on has to be looked at again
+		if (cell == Cell::settled && --drops[id].y != drops[id].top) {
+			continue;
+		}
+
+		stack.pop_back();
+	}
+}
+
+template<typename Fn>
+void Ground::for_each_reader(const Rect &rect, Fn fn) const
+{
+	for (int b = std::max(rect.y1, 0) / band_size; b <= rect.y2 / band_size && b < static_cast<int>(bands.size()); ++b) {
+		for (const auto &read : bands[b]) {
+			const Drop &drop = drops[read.id];
+
+			if (drop.alive && drop.generation == read.generation && read.rect.intersects(rect)) {
+				fn(read.id);
+			}
+		}
+	}
+}
+
+void Ground::invalidate(const Rect &rect, int first, const std::vector<bool> &skip)
+{
+	for_each_reader(rect, [&](int id) {
+		if (id < first && !(id < static_cast<int>(skip.size()) && skip[id]) && !queued[id]) {
+			queued[id] = true;
+			pending.push(id);
+		}
+	});
+}
+
+// Run id again, returning the number of drops run again.
+//
+// A drop that stopped on water written by id (or by a drop it started)
+// may only have found it flowing away because of water id wrote on top
+// of its own, and id running again could then stop on that drop's water
+// in turn, with neither flowing anywhere. So those drops are removed and
+// run again as well, and the drops that read their water, and so on,
+// except the drops that started them, which only see the outcome.
+int Ground::run_again(int id)
+{
+	const int num_old = static_cast<int>(drops.size());
+
+	std::vector<bool> in_batch(num_old, false);
+	std::vector<int> batch = { id };
+
+	in_batch[id] = true;
+
+	for (std::size_t i = 0; i < batch.size(); ++i) {
+		int d = batch[i];
+
+		for (int child : drops[d].children) {
+			if (!in_batch[child]) {
+				in_batch[child] = true;
+				batch.push_back(child);
+			}
+		}
+
+		for (const auto &rect : drops[d].writes) {
+			for_each_reader(rect, [&](int r) {
+				if (!in_batch[r] && !is_ancestor(r, d)) {
+					in_batch[r] = true;
+					batch.push_back(r);
+				}
+			});
+		}
+	}
+
+	std::vector<Rect> old_writes;
+	std::vector<int> roots;
+
+	for (int d : batch) {
+		old_writes.insert(old_writes.end(), drops[d].writes.begin(), drops[d].writes.end());
+
+		// Drops started by others in the batch are replaced when those
+		// run again
+		if (drops[d].parent >= 0 && in_batch[drops[d].parent]) {
+			drops[d].alive = false;
+		}
+		else {
+			roots.push_back(d);
+		}
+	}
+
+	// Remove their water, leaving any clay added on top of it
+	for (const auto &rect : old_writes) {
+		for (int y = rect.y1; y <= rect.y2; ++y) {
+			for (int x = rect.x1; x <= rect.x2; ++x) {
+				if (map->get(x, y) != Cell::clay) {
+					set(x, y, Cell::sand);
+				}
+			}
+		}
+	}
+
+	std::sort(roots.begin(), roots.end());
+
+	for (int d : roots) {
+		Drop &drop = drops[d];
+
+		drop.y = drop.top;
+		drop.children.clear();
+		drop.writes.clear();
+		++drop.generation;
+
+		queued[d] = false;
+	}
+
+	for (int d : roots) {
+		run(d);
+	}
+
+	std::vector<Rect> new_writes;
+
+	for (int d : roots) {
+		new_writes.insert(new_writes.end(), drops[d].writes.begin(), drops[d].writes.end());
+	}
+
+	for (int i = num_old; i < static_cast<int>(drops.size()); ++i) {
+		new_writes.insert(new_writes.end(), drops[i].writes.begin(), drops[i].writes.end());
+	}
+
+	// Other drops that read squares where the water is now different.
+	// Squares are brought up to date in the shadow once compared, as any
+	// drop reading one is found through the first rectangle with it.
+	for (const auto *rects : { &old_writes, &new_writes }) {
+		for (const auto &rect : *rects) {
+			Rect diff{rect.x2 + 1, rect.x1 - 1, rect.y2 + 1, rect.y1 - 1};
+
+			for (int y = rect.y1; y <= rect.y2; ++y) {
+				for (int x = rect.x1; x <= rect.x2; ++x) {
+					Cell cell = map->get(x, y);
+
+					if (cell != shadow->get(x, y)) {
+						shadow->set(x, y, cell);
+
+						diff.x1 = std::min(diff.x1, x);
+						diff.x2 = std::max(diff.x2, x);
+						diff.y1 = std::min(diff.y1, y);
+						diff.y2 = std::max(diff.y2, y);
+					}
+				}
+			}
+
+			if (diff.x1 <= diff.x2) {
+				invalidate(diff, num_old, in_batch);
+			}
+		}
+	}
+
+	return static_cast<int>(roots.size());
+}
+
+// Remove the drops that were replaced and the records of squares looked
+// at in earlier runs, numbering the drops left in the same order
+void Ground::compact()
+{
+	std::vector<int> new_id(drops.size(), -1);
+	int num_alive = 0;
+
+	for (std::size_t i = 0; i < drops.size(); ++i) {
+		if (drops[i].alive) {
+			new_id[i] = num_alive++;
+		}
+	}
+
+	for (auto &band : bands) {
+		band.erase(std::remove_if(band.begin(), band.end(), [&](const Read &read) {
+			return !drops[read.id].alive || drops[read.id].generation != read.generation;
+		}), band.end());
+
+		for (auto &read : band) {
+			read.id = new_id[read.id];
+		}
+	}
+
+	std::vector<Drop> kept;
+
+	kept.reserve(num_alive);
+
+	for (auto &drop : drops) {
+		if (!drop.alive) {
+			continue;
+		}
+
+		if (drop.parent >= 0) {
+			drop.parent = new_id[drop.parent];
+		}
+
+		for (int &child : drop.children) {
+			child = new_id[child];
+		}
+
+		kept.push_back(std::move(drop));
+	}
+
+	drops.swap(kept);
+	queued.assign(drops.size(), false);
+
+	reads_kept = 0;
+
+	for (const auto &band : bands) {
+		reads_kept += band.size();
+	}
+
+	drops_compacted = drops.size();
+	reads_compacted = reads_kept;
+}
+
+int Ground::edit(const Vein &vein, bool add)
+{
+	if (add) {
+		vein_list.push_back(vein);
+	}
+	else {
+		vein_list.erase(std::find(vein_list.begin(), vein_list.end(), vein));
+	}
+
+	int new_x0 = 0;
+	int new_x1 = 0;
+	int new_min_y = 0;
+	int new_max_y = 0;
+
+	if (!bounds(vein_list, new_x0, new_x1, new_min_y, new_max_y)
+	 || new_x0 != x0 || new_x1 != x1 || new_min_y != min_y || new_max_y != max_y) {
+		build();
+		return -1;
+	}
+
+	auto [x_range, y_range] = vein;
+
+	Rect rect{x_range.first, x_range.second, y_range.first, y_range.second};
+
+	if (add) {
+		for (int y = rect.y1; y <= rect.y2; ++y) {
+			for (int x = rect.x1; x <= rect.x2; ++x) {
+				set(x, y, Cell::clay);
+			}
+		}
+	}
+	else {
+		for (int y = rect.y1; y <= rect.y2; ++y) {
+			for (int x = rect.x1; x <= rect.x2; ++x) {
+				set(x, y, Cell::sand);
+			}
+		}
+
+		// Put back clay from other veins crossing the one removed
+		for (const auto &other : vein_list) {
+			Rect overlap{std::max(rect.x1, other.first.first), std::min(rect.x2, other.first.second),
+			             std::max(rect.y1, other.second.first), std::min(rect.y2, other.second.second)};
+
+			for (int y = overlap.y1; y <= overlap.y2; ++y) {
+				for (int x = overlap.x1; x <= overlap.x2; ++x) {
+					set(x, y, Cell::clay);
+				}
+			}
+		}
+	}
+
+	invalidate(rect, static_cast<int>(drops.size()), {});
+
+	for (int y = rect.y1; y <= rect.y2; ++y) {
+		for (int x = rect.x1; x <= rect.x2; ++x) {
+			shadow->set(x, y, map->get(x, y));
+		}
+	}
+
+	int num_runs = 0;
+
+	while (!pending.empty()) {
+		int id = pending.top();
+		pending.pop();
+
+		// Run again already, with a drop that depended on it
+		if (!queued[id]) {
+			continue;
+		}
+
+		queued[id] = false;
+
+		if (drops[id].alive) {
+			num_runs += run_again(id);
+		}
+	}
+
+	// Drops replaced and records of earlier runs are only left behind,
+	// so they are cleared out once there are as many as were kept, which
+	// keeps the time for that to a constant per record added
+	if (drops.size() > 2 * drops_compacted || reads_kept > 2 * reads_compacted) {
+		compact();
+	}
+
+	return num_runs;
+}
+
+std::string vein_str(const Vein &vein)
+{
+	auto [x_range, y_range] = vein;
+
+	if (x_range.first == x_range.second) {
+		return "x=" + std::to_string(x_range.first) + ", y=" + std::to_string(y_range.first) + ".." + std::to_string(y_range.second);
+	}
+
+	return "y=" + std::to_string(y_range.first) + ", x=" + std::to_string(x_range.first) + ".." + std::to_string(x_range.second);
+}
+
+int main(int argc, char *argv[])
+{
+	bool check = false;
+	int repeat = 1;
+	std::string veins_name;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+
+		if (arg == "--check") {
+			check = true;
+		}
+		else if (arg == "--repeat" && i + 1 < argc) {
+			repeat = std::max(1, std::atoi(argv[++i]));
+		}
+		else {
+			veins_name = arg;
+		}
+	}
+
+	if (veins_name.empty()) {
+		std::cerr << "usage: dec201817_edit [--check] [--repeat N] VEINS_FILE < edits.txt\n";
+		exit(1);
+	}
+
+	std::ifstream in(veins_name);
+	std::vector<Vein> veins;
+	std::string line;
+
+	while (std::getline(in, line)) {
+		Vein vein;
+
+		if (parse_vein(line, vein)) {
+			veins.push_back(vein);
+		}
+	}
+
+	std::cout << veins.size() << " veins read\n";
+
+	Ground ground(veins);
+
+	std::cout << ground.num_wet() << " wet, " << ground.num_settled() << " at rest\n";
+
+	std::vector<std::pair<Vein, bool>> edits;
+
+	while (std::getline(std::cin, line)) {
+		std::size_t sign = line.find_first_of("+-");
+		Vein vein;
+
+		if (sign != std::string::npos && parse_vein(line.substr(sign + 1), vein)) {
+			edits.emplace_back(vein, line[sign] == '+');
+		}
+	}
+
+	for (int pass = 1; pass <= repeat; ++pass) {
+		double total_ms = 0;
+		double slowest_ms = 0;
+
+		for (const auto &[vein, add] : edits) {
+			if (!add && !ground.has_vein(vein)) {
+				if (repeat == 1) {
+					std::cout << "- " << vein_str(vein) << ": not in the scan\n";
+				}
+				continue;
+			}
+
+			auto start = std::chrono::steady_clock::now();
+
+			int num_runs = ground.edit(vein, add);
+
+			auto end = std::chrono::steady_clock::now();
+
+			double ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+			total_ms += ms;
+			slowest_ms = std::max(slowest_ms, ms);
+
+			if (repeat == 1) {
+				std::cout << (add ? "+ " : "- ") << vein_str(vein) << ": "
+				          << ground.num_wet() << " wet, " << ground.num_settled() << " at rest, ";
+
+				if (num_runs < 0) {
+					std::cout << "filled again";
+				}
+				else {
+					std::cout << num_runs << " drops run again";
+				}
+
+				std::cout << " in " << ms << " ms\n";
+			}
+
+			if (check && !ground.same_water(Ground(ground.veins()))) {
+				std::cout << (add ? "+ " : "- ") << vein_str(vein) << ": MISMATCH\n";
+				exit(1);
+			}
+		}
+
+		if (repeat > 1) {
+			std::cout << "pass " << pass << ": " << edits.size() << " edits in " << total_ms << " ms, slowest "
+			          << slowest_ms << " ms, " << ground.num_wet() << " wet, " << ground.num_settled() << " at rest, "
+			          << ground.num_drops() << " drops and " << ground.num_reads() << " reads kept\n";
+		}
+	}
+
+	return 0;
+}
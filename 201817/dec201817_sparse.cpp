@@ -0,0 +1,433 @@
+//
+// Advent of Code 2018, day 17, part one and two, for sparse scans
+//
+
+// Usage: dec201817_sparse < input.txt
+//
+// The same fill as dec201817_1.cpp, without a map of every square, for
+// scans whose veins are far apart or very long (y up to 10^8 or so).
+//
+// Each row is kept as a sorted list of runs of squares that are not sand,
+// and rows that are the same are kept once, as a band of rows from one y
+// to the next. At first the bands are the rows between the ends of the
+// veins. Water splits a band where it starts or stops, so the number of
+// bands and runs grows with the number of veins and drops, and the memory
+// used does not depend on how far apart they are. The number of bands and
+// runs at the end is printed on stderr.
+//
+// The fill works on whole runs and bands rather than squares: a drop
+// falls to the next band with something in its column, a row is followed
+// to the nearest wall or edge by looking at the runs of that row and the
+// one below, and a row filled with water at rest is filled the same way
+// on every row above it in the band, so all of those rows are filled at
+// once.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <vector>
+
+using Vein = std::pair<std::pair<int, int>, std::pair<int, int>>;
+
+std::vector<Vein> read_veins()
+{
+	std::vector<Vein> veins;
+	int first_coord = 0;
+	int second_coord_first = 0;
+	int second_coord_last = 0;
+	char first_axis = 'x';
+	char second_axis = 'y';
+
+	while (std::scanf("%c=%d, %c=%d..%d ", &first_axis, &first_coord, &second_axis, &second_coord_first, &second_coord_last) == 5) {
+		if (first_axis == 'x') {
+			veins.push_back({{first_coord, first_coord}, {second_coord_first, second_coord_last}});
+		}
+		else {
+			veins.push_back({{second_coord_first, second_coord_last}, {first_coord, first_coord}});
+		}
+	}
+
+	return veins;
+}
+
+enum class Cell : std::uint8_t { sand, clay, flowing, settled };
+
+bool is_solid(Cell cell)
+{
+	return cell == Cell::clay || cell == Cell::settled;
+}
+
+// Squares x1 to x2 of a row
+struct Run {
+	int x1 = 0;
+	int x2 = 0;
+	Cell cell = Cell::sand;
+};
+
+// A row, as the runs of squares that are not sand, in order of x
+class Row {
+public:
+	Cell get(int x) const
+	{
+		auto it = find(x);
+
+		return it != runs.end() && it->x1 <= x ? it->cell : Cell::sand;
+	}
+
+	// Set squares x1 to x2
+	void set(int x1, int x2, Cell cell);
+
+	// First square from x on in direction dx where match is true, or
+	// the largest or smallest int if there is none
+	template<typename Match>
+	int next(int x, int dx, Match match) const;
+
+	// Number of squares with water, and with water at rest
+	void count_water(std::int64_t &num_wet, std::int64_t &num_settled) const
+	{
+		for (const auto &run : runs) {
+			if (run.cell == Cell::flowing || run.cell == Cell::settled) {
+				num_wet += run.x2 - run.x1 + 1;
+			}
+			if (run.cell == Cell::settled) {
+				num_settled += run.x2 - run.x1 + 1;
+			}
+		}
+	}
+
+	std::size_t size() const { return runs.size(); }
+
+private:
+	std::vector<Run> runs;
+
+	// First run ending at or after x
+	std::vector<Run>::const_iterator find(int x) const
+	{
+		return std::lower_bound(runs.begin(), runs.end(), x,
+		                        [](const Run &run, int value) { return run.x2 < value; });
+	}
+};
+
+void Row::set(int x1, int x2, Cell cell)
+{
+	auto first = runs.begin() + (find(x1) - runs.cbegin());
+	auto last = first;
+
+	while (last != runs.end() && last->x1 <= x2) {
+		++last;
+	}
+
+	// The parts of the runs replaced that are outside x1 to x2 are kept
+	std::vector<Run> middle;
+
+	if (first != last && first->x1 < x1) {
+		middle.push_back(Run{first->x1, x1 - 1, first->cell});
+	}
+
+	if (cell != Cell::sand) {
+		middle.push_back(Run{x1, x2, cell});
+	}
+
+	if (first != last && std::prev(last)->x2 > x2) {
+		middle.push_back(Run{x2 + 1, std::prev(last)->x2, std::prev(last)->cell});
+	}
+
+	std::size_t i = first - runs.begin();
+
+	runs.erase(first, last);
+	runs.insert(runs.begin() + i, middle.begin(), middle.end());
+
+	// Join the new runs with the ones next to them where they are the same
+	std::size_t lo = i > 0 ? i - 1 : 0;
+	std::size_t hi = std::min(i + middle.size() + 1, runs.size());
+	std::size_t out = lo;
+
+	for (std::size_t j = lo; j < hi; ++j) {
+		if (j > lo && runs[out - 1].cell == runs[j].cell && runs[out - 1].x2 + 1 == runs[j].x1) {
+			runs[out - 1].x2 = runs[j].x2;
+		}
+		else {
+			runs[out++] = runs[j];
+		}
+	}
+
+	runs.erase(runs.begin() + out, runs.begin() + hi);
+}
+
+template<typename Match>
+int Row::next(int x, int dx, Match match) const
+{
+	for (;;) {
+		auto it = find(x);
+
+		if (it != runs.end() && it->x1 <= x) {
+			if (match(it->cell)) {
+				return x;
+			}
+
+			x = dx > 0 ? it->x2 + 1 : it->x1 - 1;
+			continue;
+		}
+
+		if (match(Cell::sand)) {
+			return x;
+		}
+
+		// Skip the sand up to the next run
+		if (dx > 0) {
+			if (it == runs.end()) {
+				return std::numeric_limits<int>::max();
+			}
+			x = it->x1;
+		}
+		else {
+			if (it == runs.begin()) {
+				return std::numeric_limits<int>::min();
+			}
+			x = std::prev(it)->x2;
+		}
+	}
+}
+
+// Rows 0 to max_y + 1, as bands of rows that are the same, each starting
+// at its key and ending before the next
+class Ground {
+public:
+	using Band = std::map<int, Row>::iterator;
+
+	explicit Ground(int max_y_) : max_y(max_y_)
+	{
+		bands[0];
+		bands[max_y_ + 1];
+	}
+
+	int bottom() const { return max_y; }
+
+	// Band containing row y
+	Band band(int y)
+	{
+		return std::prev(bands.upper_bound(y));
+	}
+
+	// Last row of a band
+	int last_row(Band it) const
+	{
+		return std::next(it) == bands.end() ? max_y + 1 : std::next(it)->first - 1;
+	}
+
+	// Start a band at row y, returning it
+	Band split(int y)
+	{
+		Band it = band(y);
+
+		if (it->first == y) {
+			return it;
+		}
+
+		return bands.emplace_hint(std::next(it), y, it->second);
+	}
+
+	// Set squares x1 to x2 in rows y1 to y2
+	void set(int x1, int x2, int y1, int y2, Cell cell)
+	{
+		Band first = split(y1);
+		Band last = y2 + 1 <= max_y + 1 ? split(y2 + 1) : bands.end();
+
+		for (Band it = first; it != last; ++it) {
+			it->second.set(x1, x2, cell);
+		}
+	}
+
+	// Number of squares with water, and with water at rest, in rows
+	// first_y to max_y
+	void count_water(int first_y, std::int64_t &num_wet, std::int64_t &num_settled);
+
+	std::size_t num_bands() const { return bands.size(); }
+
+	std::size_t num_runs() const
+	{
+		std::size_t total = 0;
+
+		for (const auto &[y, row] : bands) {
+			total += row.size();
+		}
+
+		return total;
+	}
+
+private:
+	int max_y = 0;
+	std::map<int, Row> bands;
+};
+
+void Ground::count_water(int first_y, std::int64_t &num_wet, std::int64_t &num_settled)
+{
+	num_wet = 0;
+	num_settled = 0;
+
+	for (Band it = split(first_y); it->first <= max_y; ++it) {
+		std::int64_t wet = 0;
+		std::int64_t settled = 0;
+
+		it->second.count_water(wet, settled);
+
+		std::int64_t height = last_row(it) - it->first + 1;
+
+		num_wet += wet * height;
+		num_settled += settled * height;
+	}
+}
+
+// Stream of water falling from (x, top), with y the row it is filling
+struct Drop {
+	int x = 0;
+	int top = 0;
+	int y = 0;
+};
+
+// How a row of water ends on one side
+enum class Edge { wall, open, spill };
+
+// Follow a row from x in direction dx, with below the row under it,
+// returning how it ends, with end the last square of the row on that side
+Edge follow_row(const Row &row, const Row &below, int x, int dx, int &end)
+{
+	// First square the water can fall from, and first square in the way
+	int fall = below.next(x, dx, [](Cell cell) { return !is_solid(cell); });
+	int stop = row.next(x + dx, dx, [](Cell cell) { return cell == Cell::clay || cell == Cell::flowing; });
+
+	if (dx > 0 ? fall < stop : fall > stop) {
+		end = fall;
+		return below.get(fall) == Cell::sand ? Edge::spill : Edge::open;
+	}
+
+	end = stop - dx;
+	return row.get(stop) == Cell::clay ? Edge::wall : Edge::open;
+}
+
+void fill(Ground &ground, int spring_x)
+{
+	const int max_y = ground.bottom();
+
+	// The spring's drop falls from the row above the map, so that water
+	// filling up to row 1 spreads on row 0 like on any other row
+	std::vector<Drop> drops = { Drop{spring_x, -1, -1} };
+
+	// Whether the drop on top of the stack is new and has to fall first
+	bool falling = true;
+
+	while (!drops.empty()) {
+		Drop &drop = drops.back();
+
+		if (falling) {
+			falling = false;
+
+			// Next band with something in the drop's column
+			auto it = ground.band(drop.y + 1);
+			int land = max_y;
+
+			for (; it->first <= max_y; ++it) {
+				if (it->second.get(drop.x) != Cell::sand) {
+					land = std::max(it->first, drop.y + 1) - 1;
+					break;
+				}
+			}
+
+			if (land > drop.y) {
+				ground.set(drop.x, drop.x, drop.y + 1, land, Cell::flowing);
+				drop.y = land;
+			}
+
+			// Off the bottom of the map, or onto water known to flow away
+			if (drop.y == max_y || ground.band(drop.y + 1)->second.get(drop.x) == Cell::flowing) {
+				drops.pop_back();
+				continue;
+			}
+		}
+
+		auto it = ground.band(drop.y);
+		const Row &row = it->second;
+		const Row &below = ground.band(drop.y + 1)->second;
+
+		int l = drop.x;
+		int r = drop.x;
+
+		Edge left = follow_row(row, below, drop.x, -1, l);
+		Edge right = follow_row(row, below, drop.x, 1, r);
+
+		if (left == Edge::spill || right == Edge::spill) {
+			// The row is looked at again when this one is done
+			int x = left == Edge::spill ? l : r;
+
+			drops.push_back(Drop{x, drop.y, drop.y});
+			falling = true;
+			continue;
+		}
+
+		if (left == Edge::wall && right == Edge::wall) {
+			// The rows above in the band are the same, and have water at
+			// rest below them once this one does, so they fill the same
+			// way, up to where the drop came from
+			int y1 = std::max(it->first, drop.top + 1);
+
+			ground.set(l, r, y1, drop.y, Cell::settled);
+
+			drop.y = y1 - 1;
+
+			if (drop.y == drop.top) {
+				drops.pop_back();
+			}
+
+			continue;
+		}
+
+		ground.set(l, r, drop.y, drop.y, Cell::flowing);
+
+		drops.pop_back();
+	}
+}
+
+int main()
+{
+	auto veins = read_veins();
+
+	int min_y = std::numeric_limits<int>::max();
+	int max_y = std::numeric_limits<int>::min();
+
+	for (const auto &vein : veins) {
+		min_y = std::min(min_y, vein.second.first);
+		max_y = std::max(max_y, vein.second.second);
+	}
+
+	if (veins.empty()) {
+		std::cerr << "no veins read\n";
+		exit(1);
+	}
+
+	Ground ground(max_y);
+
+	for (const auto &vein : veins) {
+		auto [x_range, y_range] = vein;
+
+		ground.set(x_range.first, x_range.second, y_range.first, y_range.second, Cell::clay);
+	}
+
+	fill(ground, 500);
+
+	std::int64_t num_wet_tiles = 0;
+	std::int64_t num_water = 0;
+
+	ground.count_water(min_y, num_wet_tiles, num_water);
+
+	std::cerr << ground.num_bands() << " bands, " << ground.num_runs() << " runs\n";
+
+	std::cout << num_wet_tiles << '\n';
+	std::cout << num_water << '\n';
+
+	return 0;
+}
@@ -36,28 +36,34 @@
 //      439  10551292         7     63562         1       166
 //      683  10551292         7     43243         1       244
 //     1015  10551292         7     31781         1       332
+//
+// Rather than rely on this, the interpreter fast forwards loops where the
+// registers change by a constant amount each iteration. The inner loop
+// over R3 is such a loop, and skipping ahead to the iteration where
+// R3 * R5 == R1, and from there to the end of the loop, leaves about two
+// steps for each value of R5. This works for any number in R1.
+
+#include "../elfcode/elfcode.h"
 
-#include <cmath>
 #include <iostream>
 
-long long sum_divisors(long long n)
+int main()
 {
-	long long limit = static_cast<long long>(std::sqrt(n));
-	long long sum = 0;
+	auto [program, ip_reg] = read_program_ipreg();
 
-	for (long long i = 1; i <= limit; ++i) {
-		if (n % i == 0) {
-			sum += i;
-			sum += n / i;
-		}
-	}
+	std::cout << program.size() << " instructions read\n";
 
-	return sum;
-}
+	Computer c(program, ip_reg);
 
-int main()
-{
-	std::cout << sum_divisors(10551292LL) << '\n';
+	c.set_fast_forward(true);
+
+	c.registers()[0] = 1;
+
+	c.run();
+
+	std::cout << c.count() << " instructions executed, " << c.num_fast_forwards() << " fast forwards\n";
+
+	std::cout << "register 0 = " << c.registers()[0] << '\n';
 
 	return 0;
 }
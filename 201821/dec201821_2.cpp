@@ -18,43 +18,119 @@
 // The values produced in R3 repeat after a while (the cycle does not include
 // 0, which is why it runs forever by default). If we find the value before
 // the first repeat of R3, we have the longest possible run that halts.
+//
+// Rather than translate the program by hand, we run it with a breakpoint on
+// the comparison with R0 (found as in part one). The registers each time
+// the breakpoint is reached form a sequence where each entry determines the
+// next, so it ends up in a cycle. Brent's algorithm finds the length of the
+// cycle and where it starts while keeping only two copies of the computer.
+//
+// A value may repeat before the registers do, so the sequence is then run
+// again up to the end of the first cycle, marking values seen in a bitset
+// (values are below 2^24 here, which is 2 MB), and stopping at the first
+// repeated value. Values that do not fit are not tracked, and then the
+// first repeat of the registers is used.
 
+#include "../elfcode/elfcode.h"
+
+#include <bitset>
+#include <cstdint>
 #include <iostream>
-#include <unordered_set>
+#include <memory>
+#include <utility>
+
+constexpr std::size_t value_bits = 24;
+
+// Run to the next check, returning false if the program halts instead
+bool next_check(Computer &c)
+{
+	return c.run() == Computer::Status::breakpoint;
+}
 
-int find_R3_before_repeat()
+int main()
 {
-	std::unordered_set<unsigned int> seen;
+	auto [program, ip_reg] = read_program_ipreg();
+
+	std::cout << program.size() << " instructions read\n";
+
+	auto [check, value_reg] = find_halt_check(program);
+
+	Computer start(program, ip_reg);
 
-	unsigned int R0 = 0;
-	unsigned int R1 = 0;
-	unsigned int R3 = 0;
+	start.set_fast_forward(true);
+	start.set_breakpoint(check);
 
-	unsigned int prev = 0;
+	if (!next_check(start)) {
+		std::cerr << "program halts before the check\n";
+		exit(1);
+	}
 
-	do {
-		R1 = R3 | 0x00010000;
-		R3 = 10373714;
+	// Brent's algorithm, find cycle length lambda
+	std::uint64_t power = 1;
+	std::uint64_t lambda = 1;
 
-		while (R1 > 0) {
-			R3 = ((R3 + (R1 & 0xFF)) * 65899) & 0x00FFFFFF;
+	Computer tortoise = start;
+	Computer hare = start;
 
-			R1 /= 256;
+	bool halts = !next_check(hare);
+
+	while (!halts && tortoise.registers() != hare.registers()) {
+		if (power == lambda) {
+			tortoise = hare;
+			power *= 2;
+			lambda = 0;
 		}
 
-		if (auto [it, success] = seen.insert(R3); !success) {
-			return prev;
+		halts = !next_check(hare);
+		++lambda;
+	}
+
+	if (halts) {
+		std::cerr << "program halts with R0 = 0\n";
+		exit(1);
+	}
+
+	// Find start of cycle mu, with hare lambda checks ahead of tortoise
+	std::uint64_t mu = 0;
+
+	tortoise = start;
+	hare = start;
+
+	for (std::uint64_t i = 0; i < lambda; ++i) {
+		next_check(hare);
+	}
+
+	while (tortoise.registers() != hare.registers()) {
+		next_check(tortoise);
+		next_check(hare);
+		++mu;
+	}
+
+	std::cout << "cycle of " << lambda << " checks after " << mu << '\n';
+
+	// Find the last value before the first repeated value
+	auto seen = std::make_unique<std::bitset<std::size_t(1) << value_bits>>();
+
+	Computer c = start;
+	Value last = c.registers()[value_reg];
+
+	for (std::uint64_t i = 0; i < mu + lambda; ++i) {
+		Value value = c.registers()[value_reg];
+
+		if (value < seen->size()) {
+			if (seen->test(value)) {
+				break;
+			}
+
+			seen->set(value);
 		}
 
-		prev = R3;
-	} while (R3 != R0);
+		last = value;
 
-	return 0;
-}
+		next_check(c);
+	}
 
-int main()
-{
-	std::cout << find_R3_before_repeat() << '\n';
+	std::cout << last << '\n';
 
 	return 0;
 }
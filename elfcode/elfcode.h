@@ -0,0 +1,1014 @@
+//
+// Advent of Code 2018, elfcode interpreter shared by days 16, 19 and 21
+//
+
+// The program is decoded once into an array of operations, each holding
+// the address of the code that handles it, and every handler ends by
+// jumping straight to the handler of the next operation (computed goto,
+// with a switch used instead on compilers without labels as values).
+//
+// The register bound to the instruction pointer is dealt with while
+// decoding. Before every instruction it holds the address of that
+// instruction, so reading it gives a constant, and operands that read it
+// are turned into immediates. Instructions that write it are decoded to
+// jump variants of the handlers, and the others simply continue with the
+// next operation. This leaves nothing to do for the instruction pointer
+// on most instructions, and it is only stored in its register when the
+// program stops.
+//
+// Instructions with two immediate operands after this are replaced with a
+// set of the result, and immediates on the left of commutative operations
+// are moved to the right, so each operation has one of a few forms.
+//
+// A comparison followed by an add of its result to the instruction
+// pointer, which skips the next instruction if the comparison holds, is
+// the usual way to branch in elfcode. The pair is decoded to one skip
+// operation, which goes straight to one instruction or the other, so
+// there is one dispatch less on each branch.
+//
+// With fast forward enabled, jumps back to a constant address count how
+// often they are taken, and once a loop is hot, one iteration of it is
+// run symbolically, with each value an affine function v + k * s of the
+// iteration number k. If every register changes by a constant amount per
+// iteration, the comparisons along the path give the first iteration
+// where one of them has a different outcome, and all iterations before
+// that are applied at once. So a loop like
+//
+//     for (R3 = 1; R3 <= R1; ++R3) {
+//         if (R5 * R3 == R1) {
+//             R0 += R5;
+//         }
+//     }
+//
+// takes at most three steps, one to the iteration where R5 * R3 == R1,
+// that iteration, and one to the exit. Loops where this fails (a register
+// is masked, or two changing values are multiplied, say) are tried again
+// with exponential backoff.
+
+#ifndef ELFCODE_H
+#define ELFCODE_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Values in the puzzles go beyond 32 bits (products in day 19 part two),
+// and wrapping around would change the comparisons
+using Value = std::uint64_t;
+
+using Registers = std::array<Value, 6>;
+
+struct Instruction {
+	int opcode = -1;
+	unsigned int a = 0;
+	unsigned int b = 0;
+	unsigned int c = 0;
+};
+
+using Program = std::vector<Instruction>;
+
+const std::unordered_map<std::string, int> opcode_lookup = {
+	{ "addr", 0 }, { "addi", 1 },
+	{ "mulr", 2 }, { "muli", 3 },
+	{ "banr", 4 }, { "bani", 5 },
+	{ "borr", 6 }, { "bori", 7 },
+	{ "setr", 8 }, { "seti", 9 },
+	{ "gtir", 10 }, { "gtri", 11 }, { "gtrr", 12 },
+	{ "eqir", 13 }, { "eqri", 14 }, { "eqrr", 15 }
+};
+
+inline std::pair<Program, int> read_program_ipreg()
+{
+	Program program;
+	Instruction ins;
+	std::string opcode;
+	int ip_reg = -1;
+
+	// Using opcode to consume #ip
+	std::cin >> opcode >> ip_reg;
+
+	while (std::cin >> opcode >> ins.a >> ins.b >> ins.c) {
+		ins.opcode = opcode_lookup.at(opcode);
+		program.push_back(ins);
+	}
+
+	return {program, ip_reg};
+}
+
+// Find the eqrr comparing R0 with another register, returning its address
+// and the other register (day 21 halts when they are equal)
+inline std::pair<int, int> find_halt_check(const Program &program)
+{
+	const int eqrr = opcode_lookup.at("eqrr");
+
+	for (std::size_t address = 0; address < program.size(); ++address) {
+		const auto &ins = program[address];
+
+		if (ins.opcode == eqrr && (ins.a == 0) != (ins.b == 0)) {
+			return {static_cast<int>(address), static_cast<int>(ins.a == 0 ? ins.b : ins.a)};
+		}
+	}
+
+	std::cerr << "no eqrr comparing R0 with another register\n";
+	exit(1);
+}
+
+// Operations after decoding, with r = register and i = immediate
+#define ELFCODE_OPERATIONS(X) \
+	ELFCODE_ARITHMETIC(X) \
+	ELFCODE_COMPARISONS(X)
+
+#define ELFCODE_ARITHMETIC(X) \
+	X(add_rr, r[op->a] + r[op->b]) \
+	X(add_ri, r[op->a] + op->b) \
+	X(mul_rr, r[op->a] * r[op->b]) \
+	X(mul_ri, r[op->a] * op->b) \
+	X(ban_rr, r[op->a] & r[op->b]) \
+	X(ban_ri, r[op->a] & op->b) \
+	X(bor_rr, r[op->a] | r[op->b]) \
+	X(bor_ri, r[op->a] | op->b) \
+	X(set_r, r[op->a]) \
+	X(set_i, op->a)
+
+#define ELFCODE_COMPARISONS(X) \
+	X(gt_ir, static_cast<Value>(op->a > r[op->b])) \
+	X(gt_ri, static_cast<Value>(r[op->a] > op->b)) \
+	X(gt_rr, static_cast<Value>(r[op->a] > r[op->b])) \
+	X(eq_ri, static_cast<Value>(r[op->a] == op->b)) \
+	X(eq_rr, static_cast<Value>(r[op->a] == r[op->b]))
+
+#ifndef ELFCODE_COMPUTED_GOTO
+#if defined(__GNUC__)
+#define ELFCODE_COMPUTED_GOTO 1
+#else
+#define ELFCODE_COMPUTED_GOTO 0
+#endif
+#endif
+
+// Operation of a decoded instruction, see ELFCODE_OPERATIONS
+enum class Operation : std::uint8_t {
+#define X(name, expr) name,
+	ELFCODE_OPERATIONS(X)
+#undef X
+};
+
+// Instruction after decoding, with jump set if it writes the instruction
+// pointer register
+struct DecodedInstruction {
+	Operation operation = Operation::set_i;
+	Value a = 0;
+	Value b = 0;
+	std::uint32_t c = 0;
+	bool jump = false;
+};
+
+// Decode the instruction at address, as described at the top of this file
+inline DecodedInstruction decode_instruction(const Program &program, int ip_reg, std::size_t address)
+{
+	const auto &ins = program[address];
+
+	auto check_reg = [&](unsigned int r) {
+		if (r >= std::tuple_size<Registers>::value) {
+			std::cerr << "register " << r << " out of range at " << address << '\n';
+			exit(1);
+		}
+	};
+
+	// Operand modes, 'r' for register, 'i' for immediate
+	char mode_a = 'r';
+	char mode_b = 'r';
+
+	switch (ins.opcode) {
+	case 1: case 3: case 5: case 7: case 11: case 14:
+		mode_b = 'i';
+		break;
+	case 9:
+		mode_a = 'i';
+		break;
+	case 10: case 13:
+		mode_a = 'i';
+		break;
+	case 0: case 2: case 4: case 6: case 8: case 12: case 15:
+		break;
+	default:
+		std::cerr << "unknown opcode " << ins.opcode << '\n';
+		exit(1);
+		break;
+	}
+
+	bool uses_b = ins.opcode != 8 && ins.opcode != 9;
+
+	Value a = ins.a;
+	Value b = ins.b;
+
+	// Reading the instruction pointer register gives the address
+	if (mode_a == 'r') {
+		check_reg(a);
+
+		if (static_cast<int>(a) == ip_reg) {
+			mode_a = 'i';
+			a = static_cast<Value>(address);
+		}
+	}
+
+	if (uses_b && mode_b == 'r') {
+		check_reg(b);
+
+		if (static_cast<int>(b) == ip_reg) {
+			mode_b = 'i';
+			b = static_cast<Value>(address);
+		}
+	}
+
+	check_reg(ins.c);
+
+	DecodedInstruction op;
+	op.c = ins.c;
+	op.jump = static_cast<int>(ins.c) == ip_reg;
+
+	auto make = [&](Operation operation, Value a_, Value b_) {
+		op.operation = operation;
+		op.a = a_;
+		op.b = b_;
+	};
+
+	int group = ins.opcode / 2;
+
+	if (ins.opcode >= 10) {
+		group = ins.opcode < 13 ? 5 : 6;
+	}
+
+	if (!uses_b) {
+		make(mode_a == 'i' ? Operation::set_i : Operation::set_r, a, 0);
+	}
+	else if (mode_a == 'i' && mode_b == 'i') {
+		Value value = 0;
+
+		switch (group) {
+		case 0: value = a + b; break;
+		case 1: value = a * b; break;
+		case 2: value = a & b; break;
+		case 3: value = a | b; break;
+		case 5: value = static_cast<Value>(a > b); break;
+		case 6: value = static_cast<Value>(a == b); break;
+		}
+
+		make(Operation::set_i, value, 0);
+	}
+	else {
+		static const Operation rr[] = { Operation::add_rr, Operation::mul_rr, Operation::ban_rr, Operation::bor_rr, Operation::set_r, Operation::gt_rr, Operation::eq_rr };
+		static const Operation ri[] = { Operation::add_ri, Operation::mul_ri, Operation::ban_ri, Operation::bor_ri, Operation::set_i, Operation::gt_ri, Operation::eq_ri };
+
+		if (mode_a == 'r' && mode_b == 'r') {
+			make(rr[group], a, b);
+		}
+		else if (mode_a == 'r') {
+			make(ri[group], a, b);
+		}
+		else if (group == 5) {
+			make(Operation::gt_ir, a, b);
+		}
+		else {
+			// Commutative, so swap to put the immediate on the right
+			make(ri[group], b, a);
+		}
+	}
+
+	return op;
+}
+
+// How often a jump back was taken, saying when to try to fast forward its
+// loop, with exponential backoff while that fails
+struct LoopCounter {
+	std::uint32_t hits = 0;
+	std::uint32_t threshold = 16;
+
+	bool hot() { return ++hits >= threshold; }
+
+	void tried(bool skipped)
+	{
+		hits = 0;
+		threshold = skipped ? 1 : std::min(std::max(threshold, 8U) * 2, 1U << 20);
+	}
+};
+
+// Trace policy that records nothing. A policy with enabled set to true
+// has start(registers), called when run or step is entered, and
+// record(count, ip, registers), called after each instruction with the
+// number of instructions executed so far, the address of the next
+// instruction (program size if halted), and the registers with the
+// instruction pointer register as the program sees it. The calls are
+// compiled in only for enabled policies, so the interpreter is the same
+// as without tracing. See elfcode_trace.h.
+//
+// Iterations skipped by fast forward are not recorded.
+struct NoTrace {
+	static constexpr bool enabled = false;
+};
+
+template<typename Trace = NoTrace>
+class BasicComputer {
+public:
+	enum class Status { breakpoint, halted, stepped };
+
+	BasicComputer(const Program &program_, int ip_reg_, Trace trace_ = Trace())
+	 : program(program_), ip_reg(ip_reg_), breakpoints(program_.size(), false), trace(trace_)
+	{
+		decode();
+	}
+
+	// Stop before the instruction at address is executed
+	void set_breakpoint(int address)
+	{
+		breakpoints.at(address) = true;
+		decode();
+	}
+
+	// Skip iterations of loops where the registers change by a constant
+	// amount per iteration
+	void set_fast_forward(bool enable)
+	{
+		fast_forward = enable;
+		decode();
+	}
+
+	// Run until the program halts or reaches a breakpoint, calling run
+	// again continues from there
+	Status run();
+
+	// Execute the next instruction, ignoring breakpoints and without
+	// fast forward
+	Status step();
+
+	Registers &registers() { return reg; }
+	const Registers &registers() const { return reg; }
+
+	// Address of the next instruction
+	int ip() const { return static_cast<int>(next_ip); }
+
+	// Number of instructions executed, including skipped iterations
+	std::uint64_t count() const { return num_executed; }
+
+	// Number of times loop iterations were skipped
+	std::uint64_t num_fast_forwards() const { return num_skips; }
+
+	// Skip iterations of the loop starting at head like fast forward
+	// does, with r the registers at the start of an iteration, for code
+	// that runs the program itself (see elfcode_aot.cpp). Returns whether
+	// any were skipped, with r then updated.
+	bool skip_loop(std::size_t head, Registers &r)
+	{
+		reg = r;
+
+		if (!skip_iterations(head)) {
+			return false;
+		}
+
+		++num_skips;
+		r = reg;
+		return true;
+	}
+
+	bool halted() const { return next_ip >= program.size(); }
+
+private:
+	enum class Kind : std::uint8_t {
+#define X(name, expr) name, name##_jump,
+		ELFCODE_OPERATIONS(X)
+#undef X
+		halt,
+		breakpoint,
+		loop,
+#define X(name, expr) name##_skip,
+		ELFCODE_COMPARISONS(X)
+#undef X
+	};
+
+	struct Op {
+		const void *target = nullptr;
+		const void *original_target = nullptr;
+		Value a = 0;
+		Value b = 0;
+		std::uint32_t c = 0;
+		Kind kind = Kind::halt;
+		Kind original = Kind::halt;
+
+		// For loop, when to try to fast forward
+		LoopCounter counter;
+	};
+
+	// Affine function v + k * s of the iteration number k
+	struct Linear {
+		Value v = 0;
+		Value s = 0;
+	};
+
+	Program program;
+	int ip_reg = -1;
+	std::vector<bool> breakpoints;
+	bool fast_forward = false;
+	Trace trace;
+
+	// Decoded program, followed by two halt operations, for falling off
+	// the end and for jumping outside the program
+	std::vector<Op> code;
+	bool linked = false;
+
+	Registers reg = {};
+	std::size_t next_ip = 0;
+	bool resume = false;
+	std::uint64_t num_executed = 0;
+	std::uint64_t num_skips = 0;
+
+	void decode();
+
+	// Operation of op without the jump, and whether it jumps
+	static Kind base_kind(const Op &op, bool &jump)
+	{
+		int kind = static_cast<int>(op.original == Kind::loop ? Kind::set_i_jump : op.original);
+
+		jump = (kind & 1) != 0;
+
+		return static_cast<Kind>(kind & ~1);
+	}
+
+	// Which operands of base are registers, see ELFCODE_OPERATIONS
+	static void operand_modes(Kind base, bool &a_reg, bool &b_reg)
+	{
+		a_reg = base != Kind::set_i && base != Kind::gt_ir;
+		b_reg = base == Kind::add_rr || base == Kind::mul_rr || base == Kind::ban_rr || base == Kind::bor_rr
+		     || base == Kind::gt_ir || base == Kind::gt_rr || base == Kind::eq_rr;
+	}
+
+	// Value computed by op, and whether it is written to the instruction
+	// pointer register
+	static Value evaluate(const Op &op, const Registers &r, bool &jump);
+
+	static Value no_wrap(const Linear &x);
+	static Value first_change_eq(Value d, Value e);
+
+	bool skip_iterations(std::size_t head);
+	void try_fast_forward(Op &back);
+};
+
+using Computer = BasicComputer<>;
+
+template<typename Trace>
+inline void BasicComputer<Trace>::decode()
+{
+	code.clear();
+
+	for (std::size_t address = 0; address < program.size(); ++address) {
+		DecodedInstruction ins = decode_instruction(program, ip_reg, address);
+
+		// Each operation is followed by its jump variant in Kind
+		Op op;
+		op.kind = static_cast<Kind>(2 * static_cast<int>(ins.operation) + static_cast<int>(ins.jump));
+		op.a = ins.a;
+		op.b = ins.b;
+		op.c = ins.c;
+
+		if (fast_forward && op.kind == Kind::set_i_jump && op.a < address) {
+			op.kind = Kind::loop;
+		}
+
+		op.original = op.kind;
+
+		if (breakpoints[address]) {
+			op.kind = Kind::breakpoint;
+		}
+
+		code.push_back(op);
+	}
+
+	// Fuse comparisons with the jumps that skip on them, unless every
+	// instruction has to be traced or a jump has a breakpoint. Both
+	// places it can go on to must be in the program.
+	for (std::size_t address = 0; !Trace::enabled && address + 3 < code.size(); ++address) {
+		Op &op = code[address];
+		const Op &next = code[address + 1];
+
+		if (next.kind != Kind::add_ri_jump || next.a != op.c || next.b != address + 1) {
+			continue;
+		}
+
+		switch (op.kind) {
+#define X(name, expr) \
+		case Kind::name: \
+			op.kind = Kind::name##_skip; \
+			break;
+		ELFCODE_COMPARISONS(X)
+#undef X
+		default:
+			break;
+		}
+	}
+
+	code.push_back(Op{});
+	code.push_back(Op{});
+
+	linked = false;
+}
+
+template<typename Trace>
+inline void BasicComputer<Trace>::try_fast_forward(Op &back)
+{
+	bool skipped = skip_iterations(back.a + 1);
+
+	if (skipped) {
+		++num_skips;
+	}
+
+	back.counter.tried(skipped);
+}
+
+template<typename Trace>
+inline Value BasicComputer<Trace>::evaluate(const Op &op, const Registers &r, bool &jump)
+{
+	Kind base = base_kind(op, jump);
+
+	bool a_reg = false;
+	bool b_reg = false;
+	operand_modes(base, a_reg, b_reg);
+
+	Value x = a_reg ? r[op.a] : op.a;
+	Value y = b_reg ? r[op.b] : op.b;
+
+	switch (base) {
+	case Kind::add_rr: case Kind::add_ri: return x + y;
+	case Kind::mul_rr: case Kind::mul_ri: return x * y;
+	case Kind::ban_rr: case Kind::ban_ri: return x & y;
+	case Kind::bor_rr: case Kind::bor_ri: return x | y;
+	case Kind::set_r: case Kind::set_i: return x;
+	case Kind::gt_ir: case Kind::gt_ri: case Kind::gt_rr: return x > y;
+	case Kind::eq_ri: case Kind::eq_rr: return x == y;
+	default: return 0;
+	}
+}
+
+template<typename Trace>
+inline typename BasicComputer<Trace>::Status BasicComputer<Trace>::step()
+{
+	const std::size_t size = program.size();
+
+	if (next_ip >= size) {
+		return Status::halted;
+	}
+
+	if constexpr (Trace::enabled) {
+		trace.start(reg);
+	}
+
+	const Op &op = code[next_ip];
+
+	if (ip_reg >= 0) {
+		reg[ip_reg] = next_ip;
+	}
+
+	bool jump = false;
+	Value value = evaluate(op, reg, jump);
+
+	if (jump) {
+		reg[ip_reg] = value;
+		next_ip = value < size - 1 ? value + 1 : size;
+	}
+	else {
+		reg[op.c] = value;
+		++next_ip;
+	}
+
+	++num_executed;
+	resume = false;
+
+	if constexpr (Trace::enabled) {
+		trace.record(num_executed, next_ip, reg);
+	}
+
+	return next_ip >= size ? Status::halted : Status::stepped;
+}
+
+// Number of iterations k >= 0 for which x does not wrap around
+template<typename Trace>
+inline Value BasicComputer<Trace>::no_wrap(const Linear &x)
+{
+	constexpr Value max = std::numeric_limits<Value>::max();
+
+	if (x.s == 0) {
+		return max;
+	}
+
+	// Slopes of 2^63 or more are negative
+	if (x.s < (Value(1) << 63)) {
+		return (max - x.v) / x.s + 1;
+	}
+
+	return x.v / (0 - x.s) + 1;
+}
+
+// First iteration k >= 1 where d + k * e == 0 differs from k = 0, all
+// modulo 2^64
+template<typename Trace>
+inline Value BasicComputer<Trace>::first_change_eq(Value d, Value e)
+{
+	constexpr Value max = std::numeric_limits<Value>::max();
+
+	if (d == 0) {
+		return e == 0 ? max : 1;
+	}
+
+	if (e == 0) {
+		return max;
+	}
+
+	// Solve e * k == -d, where e = 2^t * odd
+	int t = 0;
+
+	while (((e >> t) & 1) == 0) {
+		++t;
+	}
+
+	Value rhs = 0 - d;
+
+	if ((rhs & ((Value(1) << t) - 1)) != 0) {
+		return max;
+	}
+
+	Value odd = e >> t;
+	Value inverse = odd;
+
+	// Each step doubles the number of correct low bits
+	for (int i = 0; i < 6; ++i) {
+		inverse *= 2 - odd * inverse;
+	}
+
+	Value mask = t == 0 ? max : (Value(1) << (64 - t)) - 1;
+
+	return ((rhs >> t) * inverse) & mask;
+}
+
+// Try to skip iterations of the loop starting at head, with reg holding
+// the registers at the start of an iteration.
+//
+// Values are followed modulo 2^64 like the registers. A comparison a > b
+// has the same outcome as long as neither side wraps around and a - b
+// does not change sign, and since a - b is linear in k, the first k where
+// it does is found by binary search. For a == b the first k where it
+// changes is found by solving a linear congruence.
+template<typename Trace>
+inline bool BasicComputer<Trace>::skip_iterations(std::size_t head)
+{
+	constexpr std::size_t max_path = 256;
+	constexpr Value max_skip = Value(1) << 62;
+	constexpr std::size_t num_regs = std::tuple_size<Registers>::value;
+
+	// Follow one iteration with the actual values to find the path and
+	// the change in each register
+	std::array<const Op *, max_path> path;
+	std::size_t path_size = 0;
+
+	Registers r = reg;
+	std::size_t ip = head;
+
+	do {
+		if (ip >= program.size() || code[ip].kind == Kind::breakpoint || path_size == max_path) {
+			return false;
+		}
+
+		const Op &op = code[ip];
+
+		path[path_size++] = &op;
+
+		bool jump = false;
+		Value value = evaluate(op, r, jump);
+
+		if (jump) {
+			if (value >= program.size()) {
+				return false;
+			}
+			ip = static_cast<std::size_t>(value) + 1;
+		}
+		else {
+			r[op.c] = value;
+			++ip;
+		}
+	} while (ip != head);
+
+	// Follow the same path with each value as a function of the
+	// iteration number, finding the number of iterations before the
+	// path changes
+	std::array<Linear, num_regs> sym;
+	std::array<bool, num_regs> written = {};
+	std::array<bool, num_regs> live_in = {};
+
+	for (std::size_t i = 0; i < num_regs; ++i) {
+		sym[i] = Linear{reg[i], r[i] - reg[i]};
+	}
+
+	Value num_iterations = max_skip;
+
+	auto at = [](const Linear &x, Value k) { return x.v + k * x.s; };
+
+	auto read = [&](Value i) {
+		if (!written[i]) {
+			live_in[i] = true;
+		}
+		return sym[i];
+	};
+
+	for (std::size_t i = 0; i < path_size; ++i) {
+		const Op &op = *path[i];
+
+		bool jump = false;
+		Kind base = base_kind(op, jump);
+
+		bool a_reg = false;
+		bool b_reg = false;
+		operand_modes(base, a_reg, b_reg);
+
+		Linear x = a_reg ? read(op.a) : Linear{op.a, 0};
+		Linear y = b_reg ? read(op.b) : Linear{op.b, 0};
+		Linear value;
+
+		switch (base) {
+		case Kind::add_rr: case Kind::add_ri:
+			value = Linear{x.v + y.v, x.s + y.s};
+			break;
+		case Kind::mul_rr: case Kind::mul_ri:
+			if (x.s != 0 && y.s != 0) {
+				return false;
+			}
+			if (x.s != 0) {
+				std::swap(x, y);
+			}
+			value = Linear{x.v * y.v, x.v * y.s};
+			break;
+		case Kind::ban_rr: case Kind::ban_ri: case Kind::bor_rr: case Kind::bor_ri:
+			if (x.s != 0 || y.s != 0) {
+				return false;
+			}
+			value.v = base == Kind::ban_rr || base == Kind::ban_ri ? (x.v & y.v) : (x.v | y.v);
+			break;
+		case Kind::set_r: case Kind::set_i:
+			value = x;
+			break;
+		case Kind::gt_ir: case Kind::gt_ri: case Kind::gt_rr: {
+			Value n = std::min({num_iterations, no_wrap(x), no_wrap(y)});
+			bool first = x.v > y.v;
+
+			if ((at(x, n - 1) > at(y, n - 1)) != first) {
+				Value lo = 0;
+				Value hi = n - 1;
+
+				while (hi - lo > 1) {
+					Value mid = lo + (hi - lo) / 2;
+
+					if ((at(x, mid) > at(y, mid)) == first) {
+						lo = mid;
+					}
+					else {
+						hi = mid;
+					}
+				}
+
+				n = hi;
+			}
+
+			num_iterations = n;
+			value.v = first;
+			break;
+		}
+		case Kind::eq_ri: case Kind::eq_rr:
+			num_iterations = std::min(num_iterations, first_change_eq(x.v - y.v, x.s - y.s));
+			value.v = x.v == y.v;
+			break;
+		default:
+			return false;
+		}
+
+		if (jump) {
+			// Jumps must go to the same place every iteration
+			if (value.s != 0) {
+				return false;
+			}
+		}
+		else {
+			sym[op.c] = value;
+			written[op.c] = true;
+		}
+	}
+
+	// Registers used before being written must change by the same
+	// amount every iteration
+	for (std::size_t i = 0; i < num_regs; ++i) {
+		if (live_in[i] && written[i] && sym[i].s != r[i] - reg[i]) {
+			return false;
+		}
+	}
+
+	if (num_iterations < 2) {
+		return false;
+	}
+
+	for (std::size_t i = 0; i < num_regs; ++i) {
+		if (written[i]) {
+			reg[i] = at(sym[i], num_iterations - 1);
+		}
+	}
+
+	num_executed += num_iterations * path_size;
+
+	return true;
+}
+
+#if ELFCODE_COMPUTED_GOTO
+#define ELFCODE_NEXT() goto *op->target
+#else
+#define ELFCODE_NEXT() goto dispatch
+#endif
+
+// Record the instruction just executed, with ip_reg_value the value of
+// the instruction pointer register after it
+#define ELFCODE_TRACE(ip_reg_value, next) \
+	if constexpr (Trace::enabled) { \
+		if (ip_reg >= 0) { \
+			r[ip_reg] = (ip_reg_value); \
+		} \
+		trace.record(count, (next), r); \
+	}
+
+template<typename Trace>
+inline typename BasicComputer<Trace>::Status BasicComputer<Trace>::run()
+{
+	if (next_ip >= program.size()) {
+		return Status::halted;
+	}
+
+	const std::size_t size = program.size();
+
+	Op *op = &code[next_ip];
+	Registers r = reg;
+	std::uint64_t count = num_executed;
+
+	// Value written to the instruction pointer register by the last jump
+	Value ip_value = 0;
+
+	if constexpr (Trace::enabled) {
+		trace.start(r);
+	}
+
+#if ELFCODE_COMPUTED_GOTO
+	static const void *const labels[] = {
+#define X(name, expr) &&name, &&name##_jump,
+		ELFCODE_OPERATIONS(X)
+#undef X
+		&&halt,
+		&&breakpoint,
+		&&loop,
+#define X(name, expr) &&name##_skip,
+		ELFCODE_COMPARISONS(X)
+#undef X
+	};
+
+	if (!linked) {
+		for (auto &o : code) {
+			o.target = labels[static_cast<int>(o.kind)];
+			o.original_target = labels[static_cast<int>(o.original)];
+		}
+
+		code[size + 1].target = &&halt_jump;
+		linked = true;
+	}
+
+	if (resume) {
+		resume = false;
+		goto *op->original_target;
+	}
+
+	ELFCODE_NEXT();
+#else
+	if (resume) {
+		resume = false;
+		goto resume_original;
+	}
+
+dispatch:
+	switch (op->kind) {
+#define X(name, expr) \
+	case Kind::name: goto name; \
+	case Kind::name##_jump: goto name##_jump;
+	ELFCODE_OPERATIONS(X)
+#undef X
+	case Kind::halt:
+		if (op == &code[size + 1]) {
+			goto halt_jump;
+		}
+		goto halt;
+	case Kind::breakpoint:
+		goto breakpoint;
+	case Kind::loop:
+		goto loop;
+#define X(name, expr) \
+	case Kind::name##_skip: goto name##_skip;
+	ELFCODE_COMPARISONS(X)
+#undef X
+	}
+
+resume_original:
+	switch (op->original) {
+#define X(name, expr) \
+	case Kind::name: goto name; \
+	case Kind::name##_jump: goto name##_jump;
+	ELFCODE_OPERATIONS(X)
+#undef X
+	case Kind::loop:
+		goto loop;
+	default:
+		goto halt;
+	}
+#endif
+
+#define X(name, expr) \
+name: \
+	r[op->c] = (expr); \
+	++count; \
+	ELFCODE_TRACE(static_cast<Value>(op - code.data()), static_cast<std::size_t>(op - code.data()) + 1); \
+	++op; \
+	ELFCODE_NEXT(); \
+name##_jump: \
+	{ \
+		ip_value = (expr); \
+		++count; \
+		ELFCODE_TRACE(ip_value, ip_value < size - 1 ? ip_value + 1 : size); \
+		op = ip_value < size - 1 ? &code[ip_value + 1] : &code[size + 1]; \
+	} \
+	ELFCODE_NEXT();
+	ELFCODE_OPERATIONS(X)
+#undef X
+
+	// The comparison, then the jump to 2 or 3 instructions on
+#define X(name, expr) \
+name##_skip: \
+	{ \
+		Value result = (expr); \
+		r[op->c] = result; \
+		count += 2; \
+		op += 2 + result; \
+	} \
+	ELFCODE_NEXT();
+	ELFCODE_COMPARISONS(X)
+#undef X
+
+loop:
+	++count;
+	ELFCODE_TRACE(op->a, op->a + 1);
+	if (op->counter.hot()) {
+		reg = r;
+		num_executed = count;
+		try_fast_forward(*op);
+		r = reg;
+		count = num_executed;
+	}
+	op = &code[op->a + 1];
+	ELFCODE_NEXT();
+
+halt:
+	// Fell off the end after the last instruction
+	if (ip_reg >= 0) {
+		r[ip_reg] = size - 1;
+	}
+	next_ip = size;
+	reg = r;
+	num_executed = count;
+	return Status::halted;
+
+halt_jump:
+	if (ip_reg >= 0) {
+		r[ip_reg] = ip_value;
+	}
+	next_ip = size;
+	reg = r;
+	num_executed = count;
+	return Status::halted;
+
+breakpoint:
+	next_ip = static_cast<std::size_t>(op - code.data());
+	if (ip_reg >= 0) {
+		r[ip_reg] = next_ip;
+	}
+	resume = true;
+	reg = r;
+	num_executed = count;
+	return Status::breakpoint;
+}
+
+#undef ELFCODE_NEXT
+#undef ELFCODE_TRACE
+
+#endif // ELFCODE_H
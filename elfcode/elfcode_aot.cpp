@@ -0,0 +1,411 @@
+//
+// Advent of Code 2018, elfcode to C++ translator
+//
+
+// Usage: elfcode_aot [--source-only] NAME < program.txt
+//
+// Translates the elfcode program on stdin, #ip line included, into C++
+// source in NAME.cpp, and compiles it into the executable NAME with the
+// compiler in $CXX (default c++). The generated source includes
+// elfcode.h, found in $ELFCODE_DIR, or by default in the directory
+// elfcode_aot.cpp was compiled from (relative to where the compiler ran,
+// if it was given a relative path).
+//
+// The generated program takes the initial values of the registers on the
+// command line (missing ones are zero), runs the elfcode, and prints the
+// registers when it halts.
+//
+// Registers are local variables and each instruction is a statement with
+// its immediates written as constants. As in the interpreter, reading the
+// instruction pointer register gives the address of the instruction, so
+// it is a constant too. Jumps to a constant address become a goto to the
+// label of that instruction, and only jumps to a computed address go
+// through the switch on the instruction pointer.
+//
+// Each jump back to a constant address counts how often it is taken, and
+// once its loop is hot, the registers are handed to the fast forward of
+// the interpreter (see elfcode.h), which skips the iterations it can and
+// hands them back. So day 19 part two with R0 = 1 takes about as long as
+// in the interpreter with fast forward (5 s), most of it in fast forward,
+// rather than the 10^14 iterations of the inner loop it takes when every
+// instruction is run.
+
+#include "elfcode.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+
+// Operand as either a constant or a register
+struct Operand {
+	std::optional<Value> value;
+	unsigned int reg = 0;
+
+	std::string str() const
+	{
+		if (value) {
+			return std::to_string(*value) + "ULL";
+		}
+
+		return "r" + std::to_string(reg);
+	}
+};
+
+class Translator {
+public:
+	Translator(const Program &program_, int ip_reg_)
+	 : program(program_), ip_reg(ip_reg_) {}
+
+	std::string translate();
+
+private:
+	const Program &program;
+	int ip_reg = -1;
+
+	Operand reg_operand(std::size_t address, unsigned int r) const
+	{
+		if (r >= std::tuple_size<Registers>::value) {
+			std::cerr << "register " << r << " out of range at " << address << '\n';
+			exit(1);
+		}
+
+		if (static_cast<int>(r) == ip_reg) {
+			return Operand{static_cast<Value>(address), 0};
+		}
+
+		return Operand{std::nullopt, r};
+	}
+
+	static Operand imm_operand(unsigned int value)
+	{
+		return Operand{value, 0};
+	}
+
+	// Expression for the value instruction at address computes, with
+	// value set if it is a constant
+	std::string expression(std::size_t address, std::optional<Value> &value) const;
+
+	void jump(std::ostream &os, std::size_t address, const std::string &expr, std::optional<Value> value) const;
+};
+
+std::string Translator::expression(std::size_t address, std::optional<Value> &value) const
+{
+	const auto &ins = program[address];
+
+	auto reg = [&](unsigned int r) { return reg_operand(address, r); };
+
+	Operand a;
+	Operand b;
+
+	switch (ins.opcode) {
+	case 0: case 2: case 4: case 6: case 12: case 15:
+		a = reg(ins.a);
+		b = reg(ins.b);
+		break;
+	case 1: case 3: case 5: case 7: case 11: case 14:
+		a = reg(ins.a);
+		b = imm_operand(ins.b);
+		break;
+	case 10: case 13:
+		a = imm_operand(ins.a);
+		b = reg(ins.b);
+		break;
+	case 8:
+		a = reg(ins.a);
+		break;
+	case 9:
+		a = imm_operand(ins.a);
+		break;
+	default:
+		std::cerr << "unknown opcode " << ins.opcode << '\n';
+		exit(1);
+		break;
+	}
+
+	bool constant = a.value && (ins.opcode == 8 || ins.opcode == 9 || b.value);
+
+	Value x = a.value.value_or(0);
+	Value y = b.value.value_or(0);
+
+	std::string expr;
+
+	switch (ins.opcode) {
+	case 0: case 1:
+		value = x + y;
+		expr = a.str() + " + " + b.str();
+		break;
+	case 2: case 3:
+		value = x * y;
+		expr = a.str() + " * " + b.str();
+		break;
+	case 4: case 5:
+		value = x & y;
+		expr = a.str() + " & " + b.str();
+		break;
+	case 6: case 7:
+		value = x | y;
+		expr = a.str() + " | " + b.str();
+		break;
+	case 8: case 9:
+		value = x;
+		expr = a.str();
+		break;
+	case 10: case 11: case 12:
+		value = static_cast<Value>(x > y);
+		expr = "(" + a.str() + " > " + b.str() + " ? 1ULL : 0ULL)";
+		break;
+	case 13: case 14: case 15:
+		value = static_cast<Value>(x == y);
+		expr = "(" + a.str() + " == " + b.str() + " ? 1ULL : 0ULL)";
+		break;
+	}
+
+	if (!constant) {
+		value.reset();
+	}
+
+	return expr;
+}
+
+void Translator::jump(std::ostream &os, std::size_t address, const std::string &expr, std::optional<Value> value) const
+{
+	std::string ip = "r" + std::to_string(ip_reg);
+
+	if (!value) {
+		os << "\t" << ip << " = " << expr << ";\n"
+		   << "\tgoto dispatch;\n";
+	}
+	else if (*value < program.size() - 1) {
+		// A jump back, which fast forward is tried on as in the
+		// interpreter
+		if (*value < address) {
+			std::string counter = "loop" + std::to_string(address);
+
+			os << "\tif (" << counter << ".hot()) {\n"
+			   << "\t\tRegisters r = { r0";
+
+			for (int r = 1; r < static_cast<int>(std::tuple_size<Registers>::value); ++r) {
+				os << ", r" << r;
+			}
+
+			os << " };\n"
+			   << "\t\tbool skipped = computer.skip_loop(" << *value + 1 << ", r);\n"
+			   << "\t\t" << counter << ".tried(skipped);\n"
+			   << "\t\tif (skipped) {\n";
+
+			for (int r = 0; r < static_cast<int>(std::tuple_size<Registers>::value); ++r) {
+				os << "\t\t\tr" << r << " = r[" << r << "];\n";
+			}
+
+			os << "\t\t}\n"
+			   << "\t}\n";
+		}
+
+		os << "\tgoto L" << *value + 1 << ";\n";
+	}
+	else {
+		os << "\t" << ip << " = " << *value << "ULL;\n"
+		   << "\tgoto halt;\n";
+	}
+}
+
+std::string Translator::translate()
+{
+	std::ostringstream os;
+
+	os << "// Generated by elfcode_aot\n"
+	   << "\n"
+	   << "#include \"elfcode.h\"\n"
+	   << "\n"
+	   << "#include <cstdlib>\n"
+	   << "#include <iostream>\n"
+	   << "\n"
+	   << "// The program, for fast forward\n"
+	   << "const Program program = {\n";
+
+	for (const auto &ins : program) {
+		os << "\t{ " << ins.opcode << ", " << ins.a << ", " << ins.b << ", " << ins.c << " },\n";
+	}
+
+	os << "};\n"
+	   << "\n"
+	   << "int main(int argc, char *argv[])\n"
+	   << "{\n";
+
+	for (int r = 0; r < static_cast<int>(std::tuple_size<Registers>::value); ++r) {
+		os << "\tValue r" << r << " = argc > " << r + 1
+		   << " ? std::strtoull(argv[" << r + 1 << "], nullptr, 10) : 0;\n";
+	}
+
+	os << "\n"
+	   << "\tComputer computer(program, " << ip_reg << ");\n";
+
+	for (std::size_t address = 0; address < program.size(); ++address) {
+		std::optional<Value> value;
+		expression(address, value);
+
+		if (static_cast<int>(program[address].c) == ip_reg && value && *value < address) {
+			os << "\tLoopCounter loop" << address << ";\n";
+		}
+	}
+
+	os << "\n"
+	   << "\tgoto L0;\n"
+	   << "\n";
+
+	// Computed jumps continue after the address written
+	if (ip_reg >= 0) {
+		os << "dispatch:\n"
+		   << "\tswitch (r" << ip_reg << ") {\n";
+
+		for (std::size_t address = 0; address + 1 < program.size(); ++address) {
+			os << "\tcase " << address << ": goto L" << address + 1 << ";\n";
+		}
+
+		os << "\tdefault: goto halt;\n"
+		   << "\t}\n"
+		   << "\n";
+	}
+
+	for (std::size_t address = 0; address < program.size(); ++address) {
+		const auto &ins = program[address];
+
+		std::optional<Value> value;
+		std::string expr = expression(address, value);
+
+		if (value) {
+			expr = std::to_string(*value) + "ULL";
+		}
+
+		os << "L" << address << ":\n";
+
+		if (static_cast<int>(ins.c) == ip_reg) {
+			jump(os, address, expr, value);
+		}
+		else {
+			os << "\tr" << ins.c << " = " << expr << ";\n";
+		}
+	}
+
+	if (ip_reg >= 0) {
+		os << "\tr" << ip_reg << " = " << (program.empty() ? 0 : program.size() - 1) << "ULL;\n";
+	}
+
+	os << "\n"
+	   << "halt:\n"
+	   << "\tstd::cout << \"registers:\"";
+
+	for (int r = 0; r < static_cast<int>(std::tuple_size<Registers>::value); ++r) {
+		os << " << ' ' << r" << r;
+	}
+
+	os << " << '\\n';\n"
+	   << "\n"
+	   << "\treturn 0;\n"
+	   << "}\n";
+
+	return os.str();
+}
+
+// Directory of elfcode.h, for the generated source to include
+std::string elfcode_dir()
+{
+	const char *dir = std::getenv("ELFCODE_DIR");
+
+	if (dir != nullptr) {
+		return dir;
+	}
+
+	std::string file = __FILE__;
+	std::size_t slash = file.rfind('/');
+
+	return slash == std::string::npos ? "." : file.substr(0, slash);
+}
+
+// Quote s as one word for the shell, in single quotes, with each single
+// quote in it ending the quoted part and added escaped
+std::string shell_quote(const std::string &s)
+{
+	std::string quoted = "'";
+
+	for (char c : s) {
+		if (c == '\'') {
+			quoted += "'\\''";
+		}
+		else {
+			quoted += c;
+		}
+	}
+
+	return quoted + "'";
+}
+
+int main(int argc, char *argv[])
+{
+	bool source_only = false;
+	std::string name;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+
+		if (arg == "--source-only") {
+			source_only = true;
+		}
+		else {
+			name = arg;
+		}
+	}
+
+	if (name.empty()) {
+		std::cerr << "usage: elfcode_aot [--source-only] NAME < program.txt\n";
+		exit(1);
+	}
+
+	auto [program, ip_reg] = read_program_ipreg();
+
+	std::cout << program.size() << " instructions read\n";
+
+	if (program.empty()) {
+		std::cerr << "no instructions to translate\n";
+		exit(1);
+	}
+
+	Translator translator(program, ip_reg);
+
+	std::string source_name = name + ".cpp";
+
+	{
+		std::ofstream out(source_name);
+
+		out << translator.translate();
+
+		if (!out) {
+			std::cerr << "unable to write " << source_name << '\n';
+			exit(1);
+		}
+	}
+
+	std::cout << "wrote " << source_name << '\n';
+
+	if (source_only) {
+		return 0;
+	}
+
+	const char *cxx = std::getenv("CXX");
+
+	std::string command = std::string(cxx != nullptr ? cxx : "c++")
+	                    + " -std=c++17 -O2 -I " + shell_quote(elfcode_dir())
+	                    + " -o " + shell_quote(name) + " " + shell_quote(source_name);
+
+	std::cout << command << '\n';
+
+	if (std::system(command.c_str()) != 0) {
+		std::cerr << "compiling " << source_name << " failed\n";
+		exit(1);
+	}
+
+	return 0;
+}
@@ -0,0 +1,319 @@
+//
+// Advent of Code 2018, elfcode runs for many initial values of R0 at once
+//
+
+// Usage: elfcode_lanes MAX_INSTRUCTIONS R0... < program.txt
+//
+// Runs the program once for each R0 value given, with the other registers
+// zero, and prints the number of instructions executed before each run
+// halts, or that it did not halt within MAX_INSTRUCTIONS. For day 21,
+// this shows how long the program runs for each candidate R0.
+//
+// Runs are done num_lanes at a time. The registers are stored by register
+// then lane, so each instruction is a loop over the lanes with no
+// dependence between them, which the compiler turns into vector code
+// (compile with -O3 -march=native to get AVX2 or AVX-512, 16 lanes of 64
+// bits is four AVX2 or two AVX-512 registers).
+//
+// The program is decoded once as in the interpreter (elfcode.h), and
+// each operation is the expression from ELFCODE_OPERATIONS applied to
+// every lane.
+//
+// After a jump the lanes can be at different instructions, so they are
+// kept as groups, a set of lanes for each address, with a bitmap of the
+// addresses that have any. The group at the lowest address runs up to its
+// next jump, with the lanes outside it masked out, and takes in any group
+// waiting at an address it reaches, so lanes that take different sides
+// of an if-else are back in step after it. While there is only one group,
+// nothing needs masking, and instruction counts are added once the group
+// changes rather than after every instruction.
+
+#include "elfcode.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+constexpr std::size_t num_lanes = 16;
+
+using Lane = std::array<Value, num_lanes>;
+
+struct Lanes {
+	std::array<Lane, std::tuple_size<Registers>::value> reg = {};
+
+	std::array<std::uint64_t, num_lanes> count = {};
+
+	// Lanes that halted, bit l for lane l
+	std::uint32_t halted = 0;
+
+	// Instructions executed by all groups, which no lane's count can be
+	// above
+	std::uint64_t steps = 0;
+
+	// Running lanes at each address, bit l for lane l, and the addresses
+	// that have any, bit i of word i / 64 for address i
+	std::vector<std::uint32_t> at;
+	std::vector<std::uint64_t> occupied;
+
+	explicit Lanes(std::size_t size) : at(size, 0), occupied((size + 63) / 64, 0) {}
+
+	void add(std::size_t address, std::uint32_t bits)
+	{
+		at[address] |= bits;
+		occupied[address / 64] |= std::uint64_t(1) << (address % 64);
+	}
+
+	// Take the group at address out, returning its lanes
+	std::uint32_t take(std::size_t address)
+	{
+		std::uint32_t bits = at[address];
+
+		at[address] = 0;
+		occupied[address / 64] &= ~(std::uint64_t(1) << (address % 64));
+
+		return bits;
+	}
+
+	// Whether there are no groups left besides ones taken out
+	bool only_group() const
+	{
+		return std::all_of(occupied.begin(), occupied.end(), [](std::uint64_t w) { return w == 0; });
+	}
+};
+
+// Registers of one lane, so the expressions in ELFCODE_OPERATIONS can
+// read r[i]
+struct LaneRegisters {
+	const std::array<Lane, std::tuple_size<Registers>::value> &reg;
+	std::size_t l;
+
+	Value operator[](Value i) const { return reg[i][l]; }
+};
+
+// Run the group of lanes at the lowest address up to its next jump,
+// returning false if no lanes are running
+bool run_group(const std::vector<DecodedInstruction> &code, std::uint64_t max_count, Lanes &lanes)
+{
+	const Value size = code.size();
+
+	std::size_t word = 0;
+
+	while (word < lanes.occupied.size() && lanes.occupied[word] == 0) {
+		++word;
+	}
+
+	if (word == lanes.occupied.size()) {
+		return false;
+	}
+
+	std::size_t current = word * 64 + static_cast<std::size_t>(__builtin_ctzll(lanes.occupied[word]));
+	std::uint32_t bits = lanes.take(current);
+
+	// All ones for lanes in the group
+	Lane mask;
+	Lane result;
+
+	// Number of instructions the group has executed since its counts
+	// were last updated
+	std::uint64_t n = 0;
+
+	auto add_counts = [&] {
+		for (std::size_t l = 0; l < num_lanes; ++l) {
+			lanes.count[l] += n & mask[l];
+		}
+		lanes.steps += n;
+		n = 0;
+	};
+
+	for (;;) {
+		for (std::size_t l = 0; l < num_lanes; ++l) {
+			mask[l] = Value(0) - ((bits >> l) & 1);
+		}
+
+		// Instructions the group can execute before a lane in it runs
+		// out, looked at lane by lane only near the end
+		std::uint64_t budget = max_count - std::min(lanes.steps, max_count);
+
+		if (budget == 0) {
+			budget = max_count;
+
+			for (std::size_t l = 0; l < num_lanes; ++l) {
+				if (((bits >> l) & 1) != 0) {
+					budget = std::min(budget, max_count - lanes.count[l]);
+				}
+			}
+		}
+
+		const bool alone = lanes.only_group();
+		const DecodedInstruction *op = nullptr;
+
+		for (;;) {
+			op = &code[current];
+
+			switch (op->operation) {
+#define X(name, expr) \
+			case Operation::name: \
+				for (std::size_t l = 0; l < num_lanes; ++l) { \
+					LaneRegisters r{lanes.reg, l}; \
+					static_cast<void>(r); \
+					result[l] = (expr); \
+				} \
+				break;
+			ELFCODE_OPERATIONS(X)
+#undef X
+			}
+
+			auto &dest = lanes.reg[op->c];
+
+			if (alone) {
+				dest = result;
+			}
+			else {
+				for (std::size_t l = 0; l < num_lanes; ++l) {
+					dest[l] = (result[l] & mask[l]) | (dest[l] & ~mask[l]);
+				}
+			}
+
+			++n;
+
+			if (op->jump || current + 1 == size || n == budget || lanes.at[current + 1] != 0) {
+				break;
+			}
+
+			++current;
+		}
+
+		if (!op->jump && current + 1 < size && n < budget) {
+			// Reached another group, which joins this one
+			add_counts();
+			bits |= lanes.take(++current);
+			continue;
+		}
+
+		add_counts();
+
+		// Lanes out of instructions stop where they are
+		std::uint32_t running = bits;
+
+		if (lanes.steps >= max_count) {
+			for (std::size_t l = 0; l < num_lanes; ++l) {
+				if (lanes.count[l] >= max_count) {
+					running &= ~(std::uint32_t(1) << l);
+				}
+			}
+		}
+
+		if (!op->jump) {
+			if (current + 1 == size) {
+				lanes.halted |= bits;
+			}
+			else if (running != 0) {
+				lanes.add(current + 1, running);
+			}
+
+			return true;
+		}
+
+		// Next instruction after a jump, with anything outside the
+		// program as halted, for all lanes jumping to the same address
+		// at once
+		for (std::uint32_t left = bits; left != 0;) {
+			Value target = result[__builtin_ctz(left)];
+			std::uint32_t same = 0;
+
+			for (std::size_t l = 0; l < num_lanes; ++l) {
+				same |= static_cast<std::uint32_t>(result[l] == target) << l;
+			}
+
+			same &= left;
+			left &= ~same;
+
+			if (target >= size - 1) {
+				lanes.halted |= same;
+			}
+			else if ((same & running) != 0) {
+				lanes.add(target + 1, same & running);
+			}
+		}
+
+		return true;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 3) {
+		std::cerr << "usage: elfcode_lanes MAX_INSTRUCTIONS R0... < program.txt\n";
+		exit(1);
+	}
+
+	std::uint64_t max_count = std::strtoull(argv[1], nullptr, 10);
+
+	std::vector<Value> r0_values;
+
+	for (int i = 2; i < argc; ++i) {
+		r0_values.push_back(std::strtoull(argv[i], nullptr, 10));
+	}
+
+	auto [program, ip_reg] = read_program_ipreg();
+
+	std::cout << program.size() << " instructions read\n";
+
+	if (program.empty()) {
+		std::cerr << "no instructions to run\n";
+		exit(1);
+	}
+
+	std::vector<DecodedInstruction> code;
+
+	for (std::size_t address = 0; address < program.size(); ++address) {
+		code.push_back(decode_instruction(program, ip_reg, address));
+	}
+
+	std::uint64_t total = 0;
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (std::size_t first = 0; first < r0_values.size(); first += num_lanes) {
+		std::size_t used = std::min(num_lanes, r0_values.size() - first);
+
+		Lanes lanes(code.size());
+
+		for (std::size_t l = 0; l < used; ++l) {
+			lanes.reg[0][l] = r0_values[first + l];
+		}
+
+		// Unused lanes are never started
+		if (max_count > 0) {
+			lanes.add(0, (std::uint32_t(1) << used) - 1);
+		}
+
+		while (run_group(code, max_count, lanes)) {
+		}
+
+		for (std::size_t l = 0; l < used; ++l) {
+			std::cout << "R0 = " << r0_values[first + l] << ": ";
+
+			if (((lanes.halted >> l) & 1) != 0) {
+				std::cout << "halted after " << lanes.count[l] << " instructions\n";
+			}
+			else {
+				std::cout << "no halt within " << max_count << " instructions\n";
+			}
+
+			total += lanes.count[l];
+		}
+	}
+
+	auto end = std::chrono::steady_clock::now();
+
+	double seconds = std::chrono::duration<double>(end - start).count();
+
+	std::cout << total << " instructions in " << seconds << " s\n";
+
+	return 0;
+}
@@ -0,0 +1,391 @@
+//
+// Advent of Code 2018, elfcode profiler
+//
+
+// Usage: elfcode_profile [--folded FILE] [R0] < program.txt
+//
+// Runs the program one instruction at a time, counting how often each
+// instruction is executed and how often each jump is taken, and prints a
+// report when the program halts, or on Ctrl-C (SIGINT) for programs that
+// run too long to finish:
+//
+//   - the basic blocks where most instructions were executed
+//   - the jumps taken most often, from one address to another
+//   - the loops, one for each jump back to an earlier instruction, with the
+//     number of iterations and how each register changed per iteration
+//
+// With --folded, the instruction counts are also written to FILE in the
+// folded stack format read by flamegraph.pl, with the loops containing a
+// basic block as the stack above it. The jump counts follow under a
+// separate root, jumps, with the address jumped from and then the address
+// jumped to as the stack, so they show up apart from the instructions.
+//
+// This steps through the program outside of Computer::run, so normal runs
+// do not pay for it.
+
+#include "elfcode.h"
+
+#include <algorithm>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+volatile std::sig_atomic_t interrupted = 0;
+
+extern "C" void handle_sigint(int)
+{
+	interrupted = 1;
+}
+
+// A jump back to an earlier instruction
+struct Loop {
+	int first = 0;
+	int last = 0;
+	std::uint64_t iterations = 0;
+
+	// Registers at the last iteration, the change since the one before,
+	// and whether that change was the same every iteration. Changes are
+	// only taken between iterations without leaving the loop in between.
+	Registers prev = {};
+	Registers delta = {};
+	std::array<bool, std::tuple_size<Registers>::value> constant = {};
+	bool have_delta = false;
+	bool left = true;
+};
+
+// A jump taken count times
+struct Jump {
+	int from = 0;
+	int to = 0;
+	std::uint64_t count = 0;
+};
+
+struct BasicBlock {
+	int first = 0;
+	int last = 0;
+	std::uint64_t executions = 0;
+	std::uint64_t instructions = 0;
+};
+
+class Profile {
+public:
+	Profile(const Program &program_, int ip_reg_)
+	 : program(program_), ip_reg(ip_reg_), executed(program_.size(), 0), loop_end(program_.size(), false),
+	   loops_over(program_.size()) {}
+
+	// Record executing the instruction at from, with the next one at to
+	// (program size if halted) and reg the registers after it
+	void record(int from, int to, const Registers &reg)
+	{
+		++executed[from];
+
+		if (to == from + 1) {
+			if (loop_end[from]) {
+				leave_loops(from, to);
+			}
+			return;
+		}
+
+		std::uint64_t key = static_cast<std::uint64_t>(from) * (program.size() + 1) + to;
+
+		++jumps[key];
+
+		leave_loops(from, to);
+
+		if (to > from) {
+			return;
+		}
+
+		auto [it, inserted] = loop_index.try_emplace(key, loops.size());
+
+		if (inserted) {
+			loops.emplace_back();
+			loops.back().first = to;
+			loops.back().last = from;
+			loops.back().constant.fill(true);
+			loop_end[from] = true;
+
+			for (int address = to; address <= from; ++address) {
+				loops_over[address].push_back(it->second);
+			}
+		}
+
+		Loop &loop = loops[it->second];
+
+		if (!inserted && !loop.left) {
+			for (std::size_t i = 0; i < reg.size(); ++i) {
+				Value delta = reg[i] - loop.prev[i];
+
+				if (loop.have_delta && delta != loop.delta[i]) {
+					loop.constant[i] = false;
+				}
+
+				loop.delta[i] = delta;
+			}
+
+			loop.have_delta = true;
+		}
+
+		loop.prev = reg;
+		loop.left = false;
+		++loop.iterations;
+	}
+
+	void report(std::ostream &os) const;
+
+	void write_folded(std::ostream &os) const;
+
+private:
+	const Program &program;
+	int ip_reg = -1;
+
+	std::vector<std::uint64_t> executed;
+	std::unordered_map<std::uint64_t, std::uint64_t> jumps;
+	std::vector<Loop> loops;
+
+	// Index in loops for each jump back, by the same key as jumps
+	std::unordered_map<std::uint64_t, std::size_t> loop_index;
+
+	// Addresses of jumps back, where falling through leaves a loop
+	std::vector<bool> loop_end;
+
+	// Indices of the loops containing each address
+	std::vector<std::vector<std::size_t>> loops_over;
+
+	void leave_loops(int from, int to)
+	{
+		for (std::size_t i : loops_over[from]) {
+			Loop &loop = loops[i];
+
+			if (to < loop.first || to > loop.last) {
+				loop.left = true;
+			}
+		}
+	}
+
+	std::vector<BasicBlock> basic_blocks() const;
+
+	std::vector<Jump> sorted_jumps() const
+	{
+		std::vector<Jump> result;
+
+		for (const auto &[key, count] : jumps) {
+			result.push_back(Jump{static_cast<int>(key / (program.size() + 1)), static_cast<int>(key % (program.size() + 1)), count});
+		}
+
+		std::sort(result.begin(), result.end(),
+		          [](const Jump &lhs, const Jump &rhs) { return lhs.count > rhs.count; });
+
+		return result;
+	}
+
+	std::vector<Loop> sorted_loops() const
+	{
+		std::vector<Loop> result = loops;
+
+		std::sort(result.begin(), result.end(),
+		          [](const Loop &lhs, const Loop &rhs) { return lhs.iterations > rhs.iterations; });
+
+		return result;
+	}
+};
+
+std::vector<BasicBlock> Profile::basic_blocks() const
+{
+	const int size = static_cast<int>(program.size());
+
+	// Blocks start at the first instruction, at jump targets, and after
+	// instructions that write the instruction pointer
+	std::vector<bool> leader(size + 1, false);
+
+	leader[0] = true;
+	leader[size] = true;
+
+	for (int address = 0; address < size; ++address) {
+		if (static_cast<int>(program[address].c) == ip_reg) {
+			leader[address + 1] = true;
+		}
+	}
+
+	for (const auto &[key, count] : jumps) {
+		int to = static_cast<int>(key % (program.size() + 1));
+
+		if (to < size) {
+			leader[to] = true;
+		}
+	}
+
+	std::vector<BasicBlock> blocks;
+
+	for (int address = 0; address < size; ++address) {
+		if (leader[address]) {
+			blocks.push_back(BasicBlock{address, address, executed[address], 0});
+		}
+
+		blocks.back().last = address;
+		blocks.back().instructions += executed[address];
+	}
+
+	return blocks;
+}
+
+void Profile::report(std::ostream &os) const
+{
+	std::uint64_t total = 0;
+
+	for (auto count : executed) {
+		total += count;
+	}
+
+	os << total << " instructions executed\n";
+
+	if (total == 0) {
+		return;
+	}
+
+	auto blocks = basic_blocks();
+
+	std::sort(blocks.begin(), blocks.end(),
+	          [](const BasicBlock &lhs, const BasicBlock &rhs) { return lhs.instructions > rhs.instructions; });
+
+	os << "\nhottest basic blocks:\n";
+
+	for (std::size_t i = 0; i < blocks.size() && i < 10 && blocks[i].instructions > 0; ++i) {
+		const auto &block = blocks[i];
+
+		os << "  " << block.first << '-' << block.last << ": "
+		   << block.executions << " executions, "
+		   << block.instructions << " instructions ("
+		   << 100.0 * static_cast<double>(block.instructions) / static_cast<double>(total) << "%)\n";
+	}
+
+	auto jump_list = sorted_jumps();
+
+	os << "\nhottest edges:\n";
+
+	for (std::size_t i = 0; i < jump_list.size() && i < 10; ++i) {
+		const auto &jump = jump_list[i];
+
+		os << "  " << jump.from << " -> " << jump.to << ": " << jump.count << " times\n";
+	}
+
+	os << "\nloops:\n";
+
+	for (const auto &loop : sorted_loops()) {
+		os << "  " << loop.first << '-' << loop.last << ": " << loop.iterations << " iterations";
+
+		if (loop.have_delta) {
+			for (std::size_t i = 0; i < loop.delta.size(); ++i) {
+				if (static_cast<int>(i) == ip_reg) {
+					continue;
+				}
+
+				if (!loop.constant[i]) {
+					os << ", R" << i << " varies";
+				}
+				else if (loop.delta[i] != 0) {
+					auto delta = static_cast<std::int64_t>(loop.delta[i]);
+
+					os << ", R" << i << (delta > 0 ? " +" : " ") << delta;
+				}
+			}
+		}
+
+		os << '\n';
+	}
+}
+
+void Profile::write_folded(std::ostream &os) const
+{
+	auto loop_list = sorted_loops();
+
+	// Outermost loops first
+	std::sort(loop_list.begin(), loop_list.end(),
+	          [](const Loop &lhs, const Loop &rhs) { return lhs.last - lhs.first > rhs.last - rhs.first; });
+
+	for (const auto &block : basic_blocks()) {
+		if (block.instructions == 0) {
+			continue;
+		}
+
+		os << "program";
+
+		for (const auto &loop : loop_list) {
+			if (loop.first <= block.first && block.last <= loop.last) {
+				os << ";loop_" << loop.first << '-' << loop.last;
+			}
+		}
+
+		os << ";block_" << block.first << '-' << block.last << ' ' << block.instructions << '\n';
+	}
+
+	for (const auto &jump : sorted_jumps()) {
+		os << "jumps;from_" << jump.from << ";to_" << jump.to << ' ' << jump.count << '\n';
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	std::string folded_name;
+	Value r0 = 0;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+
+		if (arg == "--folded" && i + 1 < argc) {
+			folded_name = argv[++i];
+		}
+		else {
+			r0 = std::strtoull(argv[i], nullptr, 10);
+		}
+	}
+
+	auto [program, ip_reg] = read_program_ipreg();
+
+	std::cout << program.size() << " instructions read\n";
+
+	Computer c(program, ip_reg);
+
+	c.registers()[0] = r0;
+
+	Profile profile(program, ip_reg);
+
+	std::signal(SIGINT, handle_sigint);
+
+	const int size = static_cast<int>(program.size());
+
+	while (!interrupted && c.ip() < size) {
+		int from = c.ip();
+
+		c.step();
+
+		profile.record(from, c.ip(), c.registers());
+	}
+
+	if (interrupted) {
+		std::cout << "interrupted at " << c.ip() << '\n';
+	}
+	else {
+		std::cout << "halted with register 0 = " << c.registers()[0] << '\n';
+	}
+
+	profile.report(std::cout);
+
+	if (!folded_name.empty()) {
+		std::ofstream out(folded_name);
+
+		profile.write_folded(out);
+
+		if (!out) {
+			std::cerr << "unable to write " << folded_name << '\n';
+			exit(1);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,218 @@
+//
+// Advent of Code 2018, trace policies for the elfcode interpreter
+//
+
+// Usage:
+//
+//     TraceWriter writer(std::cout);
+//     BasicComputer<RegisterChangeTrace> c(program, ip_reg, RegisterChangeTrace(writer));
+//
+//     c.run();
+//     writer.stop();
+//
+// The interpreter does no I/O for the trace. Records go into a ring
+// buffer with a single producer (the interpreter) and a single consumer
+// (a thread of the writer that prints them), synchronised with two
+// atomic indices and no locks. When the ring is full, records are
+// dropped and counted rather than waiting for the writer, so a full trace
+// of a long run loses records but does not slow the interpreter down to
+// the speed of the output. The number dropped is reported by stop.
+//
+// Each record is printed as the address of the next instruction followed
+// by the registers, as the day 19 solution used to print them.
+
+#ifndef ELFCODE_TRACE_H
+#define ELFCODE_TRACE_H
+
+#include "elfcode.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+struct TraceRecord {
+	std::uint64_t count = 0;
+	std::size_t ip = 0;
+	Registers reg = {};
+};
+
+// Lock-free ring buffer for one producer thread and one consumer thread
+class TraceBuffer {
+public:
+	// Capacity is rounded up to a power of two
+	explicit TraceBuffer(std::size_t capacity)
+	{
+		std::size_t size = 1;
+
+		while (size < capacity) {
+			size *= 2;
+		}
+
+		records.resize(size);
+		mask = size - 1;
+	}
+
+	// Producer only, returns false if the buffer is full
+	bool push(const TraceRecord &record)
+	{
+		std::size_t t = tail.load(std::memory_order_relaxed);
+
+		if (t - head.load(std::memory_order_acquire) == records.size()) {
+			return false;
+		}
+
+		records[t & mask] = record;
+		tail.store(t + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	// Consumer only, returns false if the buffer is empty
+	bool pop(TraceRecord &record)
+	{
+		std::size_t h = head.load(std::memory_order_relaxed);
+
+		if (h == tail.load(std::memory_order_acquire)) {
+			return false;
+		}
+
+		record = records[h & mask];
+		head.store(h + 1, std::memory_order_release);
+
+		return true;
+	}
+
+private:
+	std::vector<TraceRecord> records;
+	std::size_t mask = 0;
+
+	// Indices only ever increase, positions are taken modulo the size.
+	// Kept on separate cache lines, as each is written by one thread.
+	alignas(64) std::atomic<std::size_t> head{0};
+	alignas(64) std::atomic<std::size_t> tail{0};
+};
+
+// Prints trace records from a background thread
+class TraceWriter {
+public:
+	explicit TraceWriter(std::ostream &os_, std::size_t capacity = 1 << 16)
+	 : os(os_), buffer(capacity), writer([this] { drain(); }) {}
+
+	TraceWriter(const TraceWriter &) = delete;
+	TraceWriter &operator=(const TraceWriter &) = delete;
+
+	~TraceWriter()
+	{
+		stop();
+	}
+
+	// Called from the interpreter thread, never blocks
+	void push(const TraceRecord &record)
+	{
+		if (!buffer.push(record)) {
+			++num_dropped;
+		}
+	}
+
+	// Wait for the records pushed so far to be printed, and stop the
+	// thread. Reports dropped records on std::cerr.
+	void stop()
+	{
+		if (!writer.joinable()) {
+			return;
+		}
+
+		done.store(true, std::memory_order_release);
+		writer.join();
+
+		if (num_dropped != 0) {
+			std::cerr << num_dropped << " trace records dropped\n";
+		}
+	}
+
+	std::uint64_t dropped() const { return num_dropped; }
+
+private:
+	std::ostream &os;
+	TraceBuffer buffer;
+	std::atomic<bool> done{false};
+	std::uint64_t num_dropped = 0;
+	std::thread writer;
+
+	void drain()
+	{
+		TraceRecord record;
+
+		for (;;) {
+			// Read done first, so records pushed before it was set are
+			// seen by the pops after
+			bool last = done.load(std::memory_order_acquire);
+
+			while (buffer.pop(record)) {
+				os << record.ip << ':';
+				for (Value r : record.reg) {
+					os << ' ' << r;
+				}
+				os << '\n';
+			}
+
+			if (last) {
+				break;
+			}
+
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+
+		os.flush();
+	}
+};
+
+// Records every instruction
+class FullTrace {
+public:
+	static constexpr bool enabled = true;
+
+	explicit FullTrace(TraceWriter &writer_) : writer(&writer_) {}
+
+	void start(const Registers &) {}
+
+	void record(std::uint64_t count, std::size_t ip, const Registers &r)
+	{
+		writer->push(TraceRecord{count, ip, r});
+	}
+
+private:
+	TraceWriter *writer = nullptr;
+};
+
+// Records the instructions that change one register
+class RegisterChangeTrace {
+public:
+	static constexpr bool enabled = true;
+
+	explicit RegisterChangeTrace(TraceWriter &writer_, int watch_ = 0)
+	 : writer(&writer_), watch(watch_) {}
+
+	void start(const Registers &r)
+	{
+		last = r[watch];
+	}
+
+	void record(std::uint64_t count, std::size_t ip, const Registers &r)
+	{
+		if (r[watch] != last) {
+			last = r[watch];
+			writer->push(TraceRecord{count, ip, r});
+		}
+	}
+
+private:
+	TraceWriter *writer = nullptr;
+	int watch = 0;
+	Value last = 0;
+};
+
+#endif // ELFCODE_TRACE_H